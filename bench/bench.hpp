@@ -0,0 +1,179 @@
+#pragma once
+
+/**
+ * Shared helpers of the benchmarks: allocation counters, a clock, the peak resident set size, the best of repeated
+ * runs and the command line.
+ *
+ * Every benchmark takes --name value options, among them --repeat n: each measurement runs n times and the fastest
+ * run is reported with the allocations it made, so that a cold cache or a scheduling hiccup in one run does not count.
+ * Random input comes from std::mt19937 seeded with --seed, so the same options measure the same work.
+ *
+ * The global operator new/delete are replaced here, so this header is included by exactly one translation unit
+ * of every benchmark executable.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace bench
+{
+    inline std::atomic<std::uint64_t> allocations{0};
+    inline std::atomic<std::uint64_t> allocated_bytes{0};
+
+    /**
+     * Allocations made between construction and the call, e.g. around one workbook::read().
+     */
+    class allocation_counter
+    {
+    private:
+        std::uint64_t _count = allocations.load();
+        std::uint64_t _bytes = allocated_bytes.load();
+
+    public:
+        std::uint64_t count() const noexcept { return allocations.load() - _count; }
+        std::uint64_t bytes() const noexcept { return allocated_bytes.load() - _bytes; }
+    };
+
+    inline double now() noexcept
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * Peak resident set size of the process so far in bytes, 0 if unknown.
+     */
+    inline std::uint64_t peak_rss() noexcept
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return counters.PeakWorkingSetSize;
+        return 0;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+#ifdef __APPLE__
+        return static_cast<std::uint64_t>(usage.ru_maxrss);
+#else
+        return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+
+    struct measurement
+    {
+        double seconds = 1e300;
+        std::uint64_t allocations = 0;
+    };
+
+    /**
+     * The fastest of repeat runs of function() and the allocations of the last one.
+     */
+    template <typename Function>
+    measurement best_of(unsigned repeat, Function &&function)
+    {
+        measurement best;
+        for (unsigned i = 0; i < repeat; ++i)
+        {
+            allocation_counter counter;
+            auto start = now();
+            function();
+            best.seconds = std::min(best.seconds, now() - start);
+            best.allocations = counter.count();
+        }
+        return best;
+    }
+
+    /**
+     * Print a marker when the sum of the results of a measurement is 0. Using the results keeps the measured work
+     * from being optimised away, and a benchmark that produced nothing is visible in its output.
+     */
+    inline void keep(std::uint64_t sum)
+    {
+        if (sum == 0)
+            std::printf("(no output)\n");
+    }
+
+    /**
+     * Parse a command line of --name value options: option(name, value) is called for every pair and for every
+     * argument not starting with -- (with an empty name). False on a name without a value, when option returns false
+     * (an unknown option) or throws (a bad number).
+     */
+    template <typename Option>
+    bool parse_options(int argc, char **argv, Option &&option)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i], name;
+            if (arg.size() > 2 && arg.compare(0, 2, "--") == 0)
+            {
+                if (i + 1 == argc)
+                    return false;
+                name = arg.substr(2);
+                arg = argv[++i];
+            }
+            try
+            {
+                if (!option(name, arg))
+                    return false;
+            }
+            catch (const std::exception &)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // the replacement pairs malloc with free on purpose
+#endif
+void *operator new(std::size_t size)
+{
+    ++bench::allocations;
+    bench::allocated_bytes += size;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return operator new(size, std::nothrow); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
@@ -0,0 +1,123 @@
+#include "bench.hpp"
+
+#include <number_format.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Speed of number_format by format family.
+ *
+ *     number_format_bench [--values n] [--repeat n] [--seed n] [--filter family]
+ *
+ * Every format code of a family runs over the same array of random values, through format() (a new string per value)
+ * and format_to() (appending into one reused string), reported as ns/value and allocations/value.
+ */
+
+struct family
+{
+    const char *name;
+    std::vector<const char *> formats;
+    double min, max; // range of the random values
+    bool text = false; // format text values with format(const std::string &)
+};
+
+static const std::vector<family> families = {
+    {"general", {"General"}, -1e9, 1e9},
+    {"general small", {"General"}, -1, 1},
+    {"fixed", {"0", "0.00", "0.000000", "000000.00"}, -1e6, 1e6},
+    {"thousands", {"#,##0", "#,##0.00", "#,##0.00;[Red]-#,##0.00", "#,##0,,\"M\""}, -1e9, 1e9},
+    {"percent", {"0%", "0.00%"}, -10, 10},
+    {"scientific", {"0.00E+00", "##0.0E+0", "0.000E-00"}, -1e30, 1e30},
+    {"fraction", {"# ?/?", "# ??/??", "# ???/???", "?/8"}, -1000, 1000},
+    {"date", {"yyyy-mm-dd", "m/d/yy", "dddd, mmmm d, yyyy", "d-mmm-yy"}, 1, 60000},
+    {"time", {"hh:mm:ss", "h:mm AM/PM", "hh:mm:ss.000", "yyyy-mm-dd hh:mm"}, 1, 60000},
+    {"elapsed", {"[h]:mm:ss", "[mm]:ss", "[ss].00"}, 0, 1000},
+    {"text", {"@", "\"pre \"@\" post\"", "0;-0;0;\"text: \"@"}, 0, 1e6, true},
+};
+
+static void run(const family &family, const std::vector<double> &values, const std::vector<std::string> &texts, unsigned repeat)
+{
+    size_t length = 0;
+    std::string out;
+
+    std::vector<xlsxtext::number_format> formats;
+    for (auto code : family.formats)
+        formats.emplace_back(code);
+    auto count = formats.size() * (family.text ? texts.size() : values.size());
+
+    auto format = bench::best_of(repeat, [&]
+                                 {
+                                     for (auto &format : formats)
+                                     {
+                                         if (family.text)
+                                             for (auto &text : texts)
+                                                 length += format.format(text).size();
+                                         else
+                                             for (auto value : values)
+                                                 length += format.format(value).size();
+                                     } });
+    std::printf("%-14s format %8.1f ns/value %6.2f allocs/value", family.name, format.seconds / count * 1e9,
+                static_cast<double>(format.allocations) / count);
+    if (family.text)
+        std::printf("\n");
+    else
+    {
+        auto format_to = bench::best_of(repeat, [&]
+                                        {
+                                            for (auto &format : formats)
+                                                for (auto value : values)
+                                                {
+                                                    out.clear();
+                                                    format.format_to(out, value);
+                                                    length += out.size();
+                                                } });
+        std::printf("   format_to %8.1f ns/value %6.2f allocs/value\n", format_to.seconds / count * 1e9,
+                    static_cast<double>(format_to.allocations) / count);
+    }
+    bench::keep(length);
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = 100000;
+    unsigned repeat = 3, seed = 1;
+    std::string filter;
+    if (!bench::parse_options(argc, argv, [&](const std::string &name, const std::string &value)
+                              {
+                                  if (name == "values")
+                                      count = std::stoul(value);
+                                  else if (name == "repeat")
+                                      repeat = std::max(1ul, std::stoul(value));
+                                  else if (name == "seed")
+                                      seed = std::stoul(value);
+                                  else if (name == "filter")
+                                      filter = value;
+                                  else
+                                      return false;
+                                  return true; }))
+    {
+        std::cerr << "usage: number_format_bench [--values n] [--repeat n] [--seed n] [--filter family]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 random(seed);
+    for (auto &family : families)
+    {
+        if (!filter.empty() && family.name != filter)
+            continue;
+        std::vector<double> values(count);
+        std::vector<std::string> texts;
+        for (auto &value : values)
+            value = family.min + random() / 4294967296.0 * (family.max - family.min);
+        if (family.text)
+            for (auto value : values)
+                texts.push_back("text " + std::to_string(static_cast<long long>(value)));
+        run(family, values, texts, repeat);
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "bench.hpp"
+
+#include <xlsxtext.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Speed of cell reference parsing and printing.
+ *
+ *     reference_bench [--refs n] [--repeat n] [--seed n]
+ *
+ * The codec of xlsxtext::reference runs against the previous implementation (kept below) over the same random
+ * references, columns A to XFD and rows 1 to 1048576, reported as ns/reference and allocations/reference.
+ */
+
+namespace legacy
+{
+    static void parse(const std::string &value, unsigned &row, unsigned &col) noexcept
+    {
+        row = col = 0;
+        for (std::string::size_type i = 0; i < value.size(); ++i)
+        {
+            auto c = value[i];
+            if (row == 0 && 'A' <= c && c <= 'Z')
+                col = col * 26 + (c - 'A') + 1;
+            else if (col > 0 && '0' <= c && c <= '9')
+                row = row * 10 + (c - '0');
+            else
+            {
+                row = col = 0;
+                break;
+            }
+        }
+    }
+
+    static std::string print(unsigned row, unsigned col)
+    {
+        std::string value = "";
+        if (row > 0 && col > 0)
+        {
+            auto col_ = col;
+            while (col_ > 0)
+            {
+                char c = (col_ - 1) % 26 + 'A';
+                value = c + value;
+                col_ = (col_ - (c - 'A' + 1)) / 26;
+            }
+            value += std::to_string(row);
+        }
+        return value;
+    }
+}
+
+template <typename Function>
+static void run(const char *name, size_t count, unsigned repeat, Function &&function)
+{
+    auto best = bench::best_of(repeat, function);
+    std::printf("%-24s %8.1f ns/reference %6.2f allocs/reference\n", name, best.seconds / count * 1e9, static_cast<double>(best.allocations) / count);
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = 1000000;
+    unsigned repeat = 3, seed = 1;
+    if (!bench::parse_options(argc, argv, [&](const std::string &name, const std::string &value)
+                              {
+                                  if (name == "refs")
+                                      count = std::stoul(value);
+                                  else if (name == "repeat")
+                                      repeat = std::max(1ul, std::stoul(value));
+                                  else if (name == "seed")
+                                      seed = std::stoul(value);
+                                  else
+                                      return false;
+                                  return true; }))
+    {
+        std::cerr << "usage: reference_bench [--refs n] [--repeat n] [--seed n]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 random(seed);
+    std::vector<xlsxtext::reference> refs(count);
+    std::vector<std::string> texts(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        refs[i] = xlsxtext::reference(random() % 1048576 + 1, random() % xlsxtext::reference::max_col + 1);
+        texts[i] = legacy::print(refs[i].row, refs[i].col);
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        unsigned row, col;
+        legacy::parse(texts[i], row, col);
+        xlsxtext::reference refer(texts[i]);
+        if (refer.row != row || refer.col != col || refer.value() != texts[i])
+        {
+            std::cerr << "mismatch at " << texts[i] << std::endl;
+            return 1;
+        }
+    }
+
+    size_t sum = 0; // keeps the results alive
+    run("parse (previous)", count, repeat, [&]
+        {
+            for (auto &text : texts)
+            {
+                unsigned row, col;
+                legacy::parse(text, row, col);
+                sum += row + col;
+            } });
+    run("parse", count, repeat, [&]
+        {
+            for (auto &text : texts)
+            {
+                xlsxtext::reference refer{std::string_view(text)};
+                sum += refer.row + refer.col;
+            } });
+    run("print (previous)", count, repeat, [&]
+        {
+            for (auto &refer : refs)
+                sum += legacy::print(refer.row, refer.col).size(); });
+    run("print value()", count, repeat, [&]
+        {
+            for (auto &refer : refs)
+                sum += refer.value().size(); });
+    run("print to_chars()", count, repeat, [&]
+        {
+            char buffer[xlsxtext::reference::max_size];
+            for (auto &refer : refs)
+                sum += refer.to_chars(buffer); });
+    bench::keep(sum);
+    return 0;
+}
@@ -0,0 +1,295 @@
+#include "bench.hpp"
+
+#include <xlsxtext.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Reading benchmark over reproducible synthetic workbooks.
+ *
+ *     xlsx_bench [options] [file.xlsx ...]
+ *
+ * Without files a workbook is generated from the options (same options and seed, same bytes) and measured:
+ * open time (workbook constructor and read()), then per worksheet the read() time, cells/s, MB/s of sheet XML,
+ * C++ allocations and the peak resident set size so far.
+ */
+
+struct options
+{
+    unsigned rows = 100000;
+    unsigned cols = 20;
+    unsigned sheets = 1;
+    double sst = 0.3;        // share of cells holding a shared string
+    double inline_str = 0.05; // share of cells holding an inline string
+    double formula = 0.05;   // share of cells holding a formula with a cached value
+    double styled = 0.5;     // share of numbers with a number format (0.00, 0%, dates, custom)
+    unsigned unique = 10000; // distinct shared strings
+    unsigned merges = 100;   // merged 2x2 ranges per sheet
+    unsigned seed = 1;
+    unsigned repeat = 3;
+    std::string out = "bench.xlsx";
+    std::vector<std::string> files;
+};
+
+static const char *styles_xml =
+    R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+    R"(<styleSheet xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main">)"
+    R"(<numFmts count="2"><numFmt numFmtId="164" formatCode="#,##0.00;[Red]\-#,##0.00"/><numFmt numFmtId="165" formatCode="yyyy\-mm\-dd hh:mm"/></numFmts>)"
+    R"(<cellXfs count="6"><xf numFmtId="0"/><xf numFmtId="2"/><xf numFmtId="9"/><xf numFmtId="14"/><xf numFmtId="164"/><xf numFmtId="165"/></cellXfs>)"
+    R"(</styleSheet>)";
+
+static std::string column_name(unsigned col)
+{
+    std::string name;
+    for (; col > 0; col = (col - 1) / 26)
+        name.insert(name.begin(), static_cast<char>('A' + (col - 1) % 26));
+    return name;
+}
+
+/**
+ * Generate the workbook described by opt, returning the size of every sheet XML.
+ * Only the raw output of std::mt19937 is used and every entry has the same timestamp, so the bytes do not depend on
+ * the standard library or the clock.
+ * Sheets are written row by row to a scratch file next to the output and compressed from there,
+ * so generating does not raise the peak RSS reported for reading.
+ */
+static std::vector<size_t> generate(const options &opt)
+{
+    std::mt19937 random(opt.seed);
+    auto uniform = [&random]
+    { return random() / 4294967296.0; };
+
+    mz_zip_archive zip{};
+    if (!mz_zip_writer_init_file(&zip, opt.out.c_str(), 0))
+        throw std::runtime_error("cannot create " + opt.out);
+    MZ_TIME_T time = 1577836800; // 2020-01-01
+    auto add = [&zip, &time](const std::string &name, const std::string &data)
+    {
+        if (!mz_zip_writer_add_mem_ex_v2(&zip, name.c_str(), data.data(), data.size(), nullptr, 0, MZ_DEFAULT_COMPRESSION, 0, 0, &time, nullptr, 0, nullptr, 0))
+            throw std::runtime_error("cannot write " + name);
+    };
+
+    std::string content_types = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+                                R"(<Types xmlns="http://schemas.openxmlformats.org/package/2006/content-types">)"
+                                R"(<Default Extension="rels" ContentType="application/vnd.openxmlformats-package.relationships+xml"/>)"
+                                R"(<Default Extension="xml" ContentType="application/xml"/>)"
+                                R"(<Override PartName="/xl/workbook.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml"/>)";
+    std::string workbook = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+                           R"(<workbook xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main" xmlns:r="http://schemas.openxmlformats.org/officeDocument/2006/relationships"><sheets>)";
+    std::string workbook_rels = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+                                R"(<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">)";
+    for (unsigned i = 1; i <= opt.sheets; ++i)
+    {
+        auto n = std::to_string(i);
+        content_types += R"(<Override PartName="/xl/worksheets/sheet)" + n + R"(.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml"/>)";
+        workbook += R"(<sheet name="Sheet)" + n + R"(" sheetId=")" + n + R"(" r:id="rId)" + n + R"("/>)";
+        workbook_rels += R"(<Relationship Id="rId)" + n + R"(" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet" Target="worksheets/sheet)" + n + R"(.xml"/>)";
+    }
+    content_types += "</Types>";
+    workbook += "</sheets></workbook>";
+    workbook_rels += R"(<Relationship Id="rIdS" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings" Target="sharedStrings.xml"/>)"
+                     R"(<Relationship Id="rIdT" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles" Target="styles.xml"/>)"
+                     "</Relationships>";
+
+    add("[Content_Types].xml", content_types);
+    add("_rels/.rels", R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+                       R"(<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">)"
+                       R"(<Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument" Target="xl/workbook.xml"/>)"
+                       "</Relationships>");
+    add("xl/workbook.xml", workbook);
+    add("xl/_rels/workbook.xml.rels", workbook_rels);
+    add("xl/styles.xml", styles_xml);
+
+    auto unique = std::max(1u, opt.unique);
+    std::string sst = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+                      R"(<sst xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main" uniqueCount=")" +
+                      std::to_string(unique) + R"(">)";
+    for (unsigned i = 0; i < unique; ++i)
+        sst += i % 10 == 9 ? "<si><r><t>rich </t></r><r><rPr><b/></rPr><t>" + std::to_string(i) + "</t></r></si>"
+                           : "<si><t>text &amp; " + std::to_string(i) + "</t></si>";
+    sst += "</sst>";
+    add("xl/sharedStrings.xml", sst);
+
+    std::vector<std::string> names;
+    for (unsigned c = 1; c <= opt.cols; ++c)
+        names.push_back(column_name(c));
+    auto last = names.empty() ? std::string("A") : names.back();
+
+    std::vector<size_t> sizes;
+    char number[32];
+    auto scratch = opt.out + ".sheet.xml";
+    for (unsigned i = 1; i <= opt.sheets; ++i)
+    {
+        auto file = std::fopen(scratch.c_str(), "w+b");
+        if (!file)
+            throw std::runtime_error("cannot create " + scratch);
+        size_t size = 0;
+        auto flush = [&](std::string &xml)
+        {
+            size += std::fwrite(xml.data(), 1, xml.size(), file);
+            xml.clear();
+        };
+
+        std::string sheet = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+                            R"(<worksheet xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main">)"
+                            R"(<dimension ref="A1:)" +
+                            last + std::to_string(std::max(1u, opt.rows)) + R"("/><sheetData>)";
+        auto spans = R"(" spans="1:)" + std::to_string(opt.cols) + R"(">)";
+        for (unsigned r = 1; r <= opt.rows; ++r)
+        {
+            auto row = std::to_string(r);
+            sheet += R"(<row r=")" + row + spans;
+            for (unsigned c = 0; c < opt.cols; ++c)
+            {
+                auto refer = names[c] + row;
+                auto u = uniform();
+                if ((u -= opt.formula) < 0)
+                    sheet += R"(<c r=")" + refer + R"("><f>SUM(A)" + row + ":" + names[c] + row + ")</f><v>" + std::to_string(random() % 1000) + "</v></c>";
+                else if ((u -= opt.sst) < 0)
+                    sheet += R"(<c r=")" + refer + R"(" t="s"><v>)" + std::to_string(random() % unique) + "</v></c>";
+                else if ((u -= opt.inline_str) < 0)
+                    sheet += R"(<c r=")" + refer + R"(" t="inlineStr"><is><t>inline )" + std::to_string(random() % 100000) + "</t></is></c>";
+                else
+                {
+                    auto style = uniform() < opt.styled ? 1 + random() % 5 : 0;
+                    if (style == 3 || style == 5)
+                        std::snprintf(number, sizeof(number), "%.6f", 30000 + uniform() * 20000);
+                    else
+                        std::snprintf(number, sizeof(number), "%.10g", (uniform() - 0.3) * 1e6);
+                    sheet += R"(<c r=")" + refer + (style ? R"(" s=")" + std::to_string(style) : std::string()) + R"("><v>)" + number + "</v></c>";
+                }
+            }
+            sheet += "</row>";
+            if (sheet.size() >= 1 << 20)
+                flush(sheet);
+        }
+        sheet += "</sheetData>";
+        auto merges = std::min(opt.merges, opt.cols > 1 ? opt.rows / 3 : 0);
+        if (merges)
+        {
+            sheet += R"(<mergeCells count=")" + std::to_string(merges) + R"(">)";
+            for (unsigned k = 0; k < merges; ++k)
+            {
+                auto c = k % (opt.cols - 1);
+                sheet += R"(<mergeCell ref=")" + names[c] + std::to_string(k * 3 + 1) + ":" + names[c + 1] + std::to_string(k * 3 + 2) + R"("/>)";
+            }
+            sheet += "</mergeCells>";
+        }
+        sheet += "</worksheet>";
+        flush(sheet);
+        std::rewind(file);
+
+        auto name = "xl/worksheets/sheet" + std::to_string(i) + ".xml";
+        auto ok = mz_zip_writer_add_cfile(&zip, name.c_str(), file, size, &time, nullptr, 0, MZ_DEFAULT_COMPRESSION, nullptr, 0, nullptr, 0);
+        std::fclose(file);
+        if (!ok)
+            throw std::runtime_error("cannot write " + name);
+        sizes.push_back(size);
+    }
+    std::remove(scratch.c_str());
+
+    if (!mz_zip_writer_finalize_archive(&zip) || !mz_zip_writer_end(&zip))
+        throw std::runtime_error("cannot finalize " + opt.out);
+    return sizes;
+}
+
+static bool parse(int argc, char **argv, options &opt)
+{
+    return bench::parse_options(argc, argv, [&opt](const std::string &name, const std::string &value)
+                                {
+                                    if (name.empty())
+                                        opt.files.push_back(value);
+                                    else if (name == "rows")
+                                        opt.rows = std::stoul(value);
+                                    else if (name == "cols")
+                                        opt.cols = std::stoul(value);
+                                    else if (name == "sheets")
+                                        opt.sheets = std::stoul(value);
+                                    else if (name == "sst")
+                                        opt.sst = std::stod(value);
+                                    else if (name == "inline")
+                                        opt.inline_str = std::stod(value);
+                                    else if (name == "formula")
+                                        opt.formula = std::stod(value);
+                                    else if (name == "styled")
+                                        opt.styled = std::stod(value);
+                                    else if (name == "unique")
+                                        opt.unique = std::stoul(value);
+                                    else if (name == "merges")
+                                        opt.merges = std::stoul(value);
+                                    else if (name == "seed")
+                                        opt.seed = std::stoul(value);
+                                    else if (name == "repeat")
+                                        opt.repeat = std::max(1ul, std::stoul(value));
+                                    else if (name == "out")
+                                        opt.out = value;
+                                    else
+                                        return false;
+                                    return true; });
+}
+
+static void measure(const std::string &path, const std::vector<size_t> &sizes, unsigned repeat)
+{
+    std::printf("%s\n", path.c_str());
+
+    auto open = bench::best_of(repeat, [&path]
+                               {
+                                   xlsxtext::workbook workbook(path);
+                                   if (!workbook.read())
+                                       throw std::runtime_error("cannot open " + path); });
+    std::printf("  open        %10.3f ms %12llu allocs %10.1f MB peak rss\n", open.seconds * 1e3,
+                static_cast<unsigned long long>(open.allocations), bench::peak_rss() / 1048576.0);
+
+    xlsxtext::workbook workbook(path);
+    workbook.read();
+    size_t index = 0;
+    for (auto worksheet : workbook) // an unread copy, as cheap as the name and part it holds
+    {
+        std::uint64_t errors = 0;
+        auto best = bench::best_of(repeat, [&]
+                                   { errors = worksheet.read().total(); });
+        std::uint64_t cells = worksheet.rows().cell_count();
+        std::printf("  %-12s%10.3f ms %12llu allocs %10.1f MB peak rss %10.2f Mcells/s", worksheet.name().c_str(), best.seconds * 1e3,
+                    static_cast<unsigned long long>(best.allocations), bench::peak_rss() / 1048576.0, cells / best.seconds / 1e6);
+        if (index < sizes.size())
+            std::printf(" %8.1f MB/s", sizes[index] / best.seconds / 1048576.0);
+        std::printf(" (%llu cells, %llu errors)\n", static_cast<unsigned long long>(cells), static_cast<unsigned long long>(errors));
+        ++index;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    options opt;
+    if (!parse(argc, argv, opt))
+    {
+        std::cerr << "usage: xlsx_bench [--rows n] [--cols n] [--sheets n] [--sst share] [--inline share] [--formula share]" << std::endl
+                  << "                  [--styled share] [--unique n] [--merges n] [--seed n] [--repeat n] [--out file.xlsx] [file.xlsx ...]" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        if (opt.files.empty())
+        {
+            auto start = bench::now();
+            auto sizes = generate(opt);
+            std::printf("generated %u x %u cells in %u sheet(s) in %.3f s\n", opt.rows, opt.cols, opt.sheets, bench::now() - start);
+            measure(opt.out, sizes, opt.repeat);
+        }
+        for (auto &file : opt.files)
+            measure(file, {}, opt.repeat);
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -3175,6 +3175,15 @@ void test_number_format()
             xlsxtext::number_format fmt(tc.format_code);
             std::string result = tc.is_number() ? fmt.format(tc.number(), tc.date1904) : fmt.format(tc.text());
             bool pass = (result == tc.expected);
+            if (tc.is_number())
+            {
+                // format_to must append exactly what format returns
+                std::string appended = "> ";
+                fmt.format_to(appended, tc.number(), tc.date1904);
+                char buf[256];
+                auto n = fmt.format_to(buf, sizeof(buf), tc.number(), tc.date1904);
+                pass = pass && appended == "> " + result && n == result.size() && result.compare(0, sizeof(buf) - 1, buf) == 0;
+            }
             if (pass)
             {
                 total.passed++;
@@ -0,0 +1,128 @@
+#include <xlsxtext.hpp>
+
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+struct test_result
+{
+    int passed = 0;
+    int failed = 0;
+};
+
+static test_result total;
+
+static void check(bool pass, const std::string &name, const std::string &result = "", const std::string &expected = "")
+{
+    if (pass)
+    {
+        total.passed++;
+        return;
+    }
+    total.failed++;
+    std::cout << "[FAIL] " << name;
+    if (!result.empty() || !expected.empty())
+        std::cout << " => got: \"" << result << "\", expected: \"" << expected << "\"";
+    std::cout << std::endl;
+}
+
+static std::string parsed(const xlsxtext::reference &refer)
+{
+    return std::to_string(refer.row) + "," + std::to_string(refer.col);
+}
+
+static void check_parse(const std::string &value, unsigned row, unsigned col)
+{
+    auto expected = std::to_string(row) + "," + std::to_string(col);
+    auto result = parsed(xlsxtext::reference(value));
+    check(result == expected, "parse " + value, result, expected);
+    result = parsed(xlsxtext::reference(std::string_view(value)));
+    check(result == expected, "parse view " + value, result, expected);
+}
+
+void test_parse()
+{
+    check_parse("A1", 1, 1);
+    check_parse("B17", 17, 2);
+    check_parse("Z9", 9, 26);
+    check_parse("AA10", 10, 27);
+    check_parse("AZ1", 1, 52);
+    check_parse("ZZ1", 1, 702);
+    check_parse("AAA1", 1, 703);
+    check_parse("XFD1048576", 1048576, 16384);
+    check_parse("XFE1", 1, 16385);
+    check_parse("A01", 1, 1);
+    check_parse("MWLQKWU4294967295", 4294967295u, 4294967295u); // the largest of both, max_size characters
+
+    // malformed: every one is the invalid reference (0, 0)
+    for (auto value : {"", "A", "XFD", "1", "17", "Z0Z55", "A0", "A1B", "A1 ", " A1", "a1", "$A$1", "A-1", "A1:B2", "1A",
+                       "A4294967296", "MWLQKWV1", "AAAAAAAAAA1", "A99999999999"})
+        check_parse(value, 0, 0);
+    check(!xlsxtext::reference("Z0Z55") && !xlsxtext::reference("A") && xlsxtext::reference("A1"), "operator bool");
+
+    // a view is not read past its end
+    std::string text = "C5D";
+    check(parsed(xlsxtext::reference(std::string_view(text.data(), 2))) == "5,3", "parse a prefix");
+}
+
+void test_print()
+{
+    char buffer[xlsxtext::reference::max_size];
+    auto print = [&](unsigned row, unsigned col)
+    { return std::string(buffer, xlsxtext::reference(row, col).to_chars(buffer)); };
+    check(print(1, 1) == "A1" && print(17, 2) == "B17" && print(1048576, 16384) == "XFD1048576", "to_chars");
+    check(print(1, 16385) == "XFE1", "to_chars past XFD", print(1, 16385), "XFE1");
+    check(print(4294967295u, 4294967295u) == "MWLQKWU4294967295", "to_chars of the largest reference", print(4294967295u, 4294967295u), "");
+    check(print(0, 1).empty() && print(1, 0).empty() && xlsxtext::reference().value().empty(), "invalid references print nothing");
+
+    check(xlsxtext::reference::column_name(1) == "A" && xlsxtext::reference::column_name(26) == "Z" && xlsxtext::reference::column_name(27) == "AA" &&
+              xlsxtext::reference::column_name(16384) == "XFD",
+          "column_name");
+    check(xlsxtext::reference::column_name(0).empty() && xlsxtext::reference::column_name(16385).empty(), "column_name out of range");
+
+    // every column and a spread of rows survive printing and parsing
+    std::string wrong;
+    for (unsigned col = 1; col <= xlsxtext::reference::max_col + 100; ++col)
+    {
+        auto row = col * 64 + 1;
+        xlsxtext::reference refer(row, col);
+        auto value = refer.value();
+        xlsxtext::reference back(value);
+        if (back.row != row || back.col != col || (col <= xlsxtext::reference::max_col && value.compare(0, xlsxtext::reference::column_name(col).size(), xlsxtext::reference::column_name(col)) != 0))
+            wrong += value + " ";
+    }
+    check(wrong.empty(), "round trip of every column", wrong, "");
+}
+
+int main()
+{
+#ifdef _WIN32
+    auto __con_out_cp = GetConsoleOutputCP();
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    std::cout << "=== reference Tests ===" << std::endl
+              << std::endl;
+
+    test_parse();
+    test_print();
+
+    std::cout << std::endl;
+    std::cout << "=== Test Summary ===" << std::endl;
+    std::cout << "Passed: " << total.passed << std::endl;
+    std::cout << "Failed: " << total.failed << std::endl;
+    std::cout << "Total:  " << (total.passed + total.failed) << std::endl;
+
+    if (total.failed == 0)
+        std::cout << "\n*** ALL TESTS PASSED ***" << std::endl;
+    else
+        std::cout << "\n*** " << total.failed << " TEST(S) FAILED ***" << std::endl;
+
+#ifdef _WIN32
+    SetConsoleOutputCP(__con_out_cp);
+#endif
+    return total.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,670 @@
+#include <xlsxtext.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+struct test_result
+{
+    int passed = 0;
+    int failed = 0;
+};
+
+static test_result total;
+
+static void check(bool pass, const std::string &name, const std::string &result = "", const std::string &expected = "")
+{
+    if (pass)
+    {
+        total.passed++;
+        return;
+    }
+    total.failed++;
+    std::cout << "[FAIL] " << name;
+    if (!result.empty() || !expected.empty())
+        std::cout << " => got: \"" << result << "\", expected: \"" << expected << "\"";
+    std::cout << std::endl;
+}
+
+/**
+ * An xlsx file in memory with one worksheet per entry of sheets (the content of its worksheet element), the shared
+ * strings (si elements or a whole sst element) and the cell formats (xf elements, custom number formats from id 164
+ * in numfmts order).
+ */
+static std::string xlsx(const std::vector<std::string> &sheets, const std::string &sst = "", const std::string &xfs = "",
+                        const std::vector<std::string> &numfmts = {})
+{
+    mz_zip_archive zip{};
+    mz_zip_writer_init_heap(&zip, 0, 0);
+    auto add = [&zip](const std::string &name, const std::string &data)
+    { mz_zip_writer_add_mem(&zip, name.c_str(), data.data(), data.size(), MZ_DEFAULT_COMPRESSION); };
+
+    std::string workbook = R"(<workbook xmlns:r="http://schemas.openxmlformats.org/officeDocument/2006/relationships"><sheets>)";
+    std::string rels = "<Relationships>"
+                       R"(<Relationship Id="rIdS" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings" Target="sharedStrings.xml"/>)"
+                       R"(<Relationship Id="rIdT" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles" Target="styles.xml"/>)";
+    for (size_t i = 1; i <= sheets.size(); ++i)
+    {
+        auto n = std::to_string(i);
+        workbook += R"(<sheet name="Sheet)" + n + R"(" sheetId=")" + n + R"(" r:id="rId)" + n + R"("/>)";
+        rels += R"(<Relationship Id="rId)" + n + R"(" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet" Target="worksheets/sheet)" + n + R"(.xml"/>)";
+        add("xl/worksheets/sheet" + n + ".xml", "<worksheet>" + sheets[i - 1] + "</worksheet>");
+    }
+    add("xl/workbook.xml", workbook + "</sheets></workbook>");
+    add("xl/_rels/workbook.xml.rels", rels + "</Relationships>");
+    add("xl/sharedStrings.xml", sst.compare(0, 4, "<sst") == 0 ? sst : "<sst>" + sst + "</sst>");
+    std::string styles = "<styleSheet><numFmts>";
+    for (size_t i = 0; i < numfmts.size(); ++i)
+        styles += R"(<numFmt numFmtId=")" + std::to_string(164 + i) + R"(" formatCode=")" + numfmts[i] + R"("/>)";
+    add("xl/styles.xml", styles + "</numFmts><cellXfs>" + xfs + "</cellXfs></styleSheet>");
+
+    void *data = nullptr;
+    size_t size = 0;
+    mz_zip_writer_finalize_heap_archive(&zip, &data, &size);
+    std::string file(static_cast<const char *>(data), size);
+    mz_zip_writer_end(&zip);
+    return file;
+}
+
+/**
+ * The rows of a read worksheet as lines of "row: A1=value B1=value".
+ */
+static std::string dump(const xlsxtext::worksheet &worksheet)
+{
+    std::string out;
+    for (auto row : worksheet)
+    {
+        out += std::to_string(row.index()) + ":";
+        for (auto cell : row)
+            out += " " + cell.refer.value() + "=" + std::string(cell.value);
+        out += "\n";
+    }
+    return out;
+}
+
+static std::string dump(const xlsxtext::read_errors &errors)
+{
+    std::string out;
+    for (auto &error : errors)
+        out += (error.row ? error.refer().value() + " " : std::string()) + error.message() + "\n";
+    return out;
+}
+
+/**
+ * sheetData of rows rows, every row holding a number, a shared string and an inline string.
+ */
+static std::string sheet_data(unsigned rows, const std::string &middle = "")
+{
+    std::string xml = "<sheetData>";
+    for (unsigned r = 1; r <= rows; ++r)
+    {
+        auto n = std::to_string(r);
+        if (r == rows / 2)
+            xml += middle;
+        xml += R"(<row r=")" + n + R"("><c r="A)" + n + R"("><v>)" + n + R"(.5</v></c><c r="B)" + n + R"(" t="s"><v>)" +
+               std::to_string(r % 2) + R"(</v></c><c r="C)" + n + R"(" t="inlineStr"><is><t>row )" + n + "</t></is></c></row>";
+    }
+    return xml + "</sheetData>";
+}
+
+void test_split_rows()
+{
+    // every piece but the first starts at a row with an r attribute
+    std::string xml = R"(<worksheet><dimension ref="A1:A4"/><sheetData><row r="1"><c r="A1"><v>1</v></c></row><row><c><v>2</v></c></row>)"
+                      R"(<row r="3"><c r="A3"><v>3</v></c></row><rowx/><row r="4"/></sheetData></worksheet>)";
+    for (size_t count = 1; count <= 8; ++count)
+    {
+        auto splits = xlsxtext::worksheet::split_rows(xml.data(), xml.size(), count);
+        bool ok = splits.size() >= 2 && splits.size() <= count + 1 && splits.front() == 0 && splits.back() == xml.size();
+        for (size_t i = 1; ok && i + 1 < splits.size(); ++i)
+            ok = splits[i] > splits[i - 1] && (xml.compare(splits[i], 8, R"(<row r=")") == 0);
+        std::string result;
+        for (auto split : splits)
+            result += std::to_string(split) + " ";
+        check(ok, "split_rows into " + std::to_string(count), result, "");
+    }
+    std::vector<size_t> expected{0, xml.find(R"(<row r="1")"), xml.find(R"(<row r="3")"), xml.find(R"(<row r="4")"), xml.size()};
+    check(xlsxtext::worksheet::split_rows(xml.data(), xml.size(), 100) == expected, "split_rows skips rows without r");
+
+    // no sheetData or no room for a split: one piece
+    std::string empty = "<worksheet><sheetData/></worksheet>";
+    check(xlsxtext::worksheet::split_rows(empty.data(), empty.size(), 4) == std::vector<size_t>{0, empty.size()}, "split_rows without rows");
+    std::string none = "<worksheet/>";
+    check(xlsxtext::worksheet::split_rows(none.data(), none.size(), 4) == std::vector<size_t>{0, none.size()}, "split_rows without sheetData");
+}
+
+void test_parallel_read()
+{
+    // several MB of sheet XML so that read(threads) splits it
+    std::string sst = "<si><t>even</t></si><si><t>odd</t></si>";
+    std::string merges = R"(<mergeCells><mergeCell ref="A2:B3"/><mergeCell ref="C40000:C40001"/></mergeCells>)";
+    auto file = xlsx({R"(<dimension ref="A1:C60000"/>)" + sheet_data(60000) + merges}, sst);
+    auto workbook = xlsxtext::workbook::from_memory(file.data(), file.size());
+    check(workbook.read(), "workbook read");
+    auto worksheet = workbook.worksheets()[0];
+    auto errors = dump(worksheet.read());
+    auto expected = dump(worksheet);
+    check(worksheet.rows().size() == 60000 && worksheet.merges().ranges().size() == 2, "serial read", std::to_string(worksheet.rows().size()), "60000");
+    for (unsigned threads : {2u, 3u, 8u})
+    {
+        auto parallel = dump(worksheet.read(threads));
+        auto result = dump(worksheet);
+        check(result == expected && parallel == errors, "parallel read with " + std::to_string(threads) + " threads");
+        check(worksheet.merges().ranges().size() == 2 && worksheet.dimension().rows() == 60000, "parallel merges and dimension");
+    }
+
+    // a split point inside a comment holding a row: the pieces do not fit together and the serial reader takes over
+    std::string comment = "<!--";
+    for (unsigned r = 0; r < 40000; ++r)
+        comment += R"(<row r="99"><c r="A99"><v>comment</v></c></row>)";
+    comment += "-->";
+    auto commented = xlsx({sheet_data(20000, comment)}, sst);
+    auto commented_workbook = xlsxtext::workbook::from_memory(commented.data(), commented.size());
+    check(commented_workbook.read(), "workbook read");
+    worksheet = commented_workbook.worksheets()[0];
+    worksheet.read();
+    expected = dump(worksheet);
+    check(worksheet.rows().size() == 20000 && expected.find("comment") == std::string::npos, "serial read skips the comment");
+    errors = dump(worksheet.read(4));
+    check(dump(worksheet) == expected && errors.empty(), "serial fallback for a split inside a comment");
+
+    // a broken part fails the same way on both paths
+    auto broken = xlsx({sheet_data(20000, "<row><c>< broken/></c></row>")}, sst);
+    auto broken_workbook = xlsxtext::workbook::from_memory(broken.data(), broken.size());
+    check(broken_workbook.read(), "workbook read");
+    worksheet = broken_workbook.worksheets()[0];
+    errors = dump(worksheet.read());
+    check(errors == "workseet open failed\n" && worksheet.rows().empty(), "serial read of a broken part", errors, "workseet open failed\n");
+    check(dump(worksheet.read(4)) == errors && worksheet.rows().empty(), "parallel read of a broken part");
+}
+
+void test_wide_row()
+{
+    // a row of several MB spans many part chunks, the rows around it one chunk each
+    std::string wide = R"(<row r="2">)";
+    for (unsigned c = 1; c <= 4000; ++c)
+        wide += R"(<c t="inlineStr"><is><t>)" + std::to_string(c) + std::string(1000, 'x') + "</t></is></c>";
+    wide += "</row>";
+    auto file = xlsx({R"(<sheetData><row r="1"><c r="A1"><v>1</v></c></row>)" + wide + R"(<row r="3"><c r="A3"><v>3</v></c></row></sheetData>)"});
+    auto workbook = xlsxtext::workbook::from_memory(file.data(), file.size());
+    check(workbook.read(), "workbook read");
+    auto worksheet = workbook.worksheets()[0];
+    auto errors = dump(worksheet.read());
+    auto &rows = worksheet.rows();
+    bool ok = errors.empty() && rows.size() == 3 && rows.cell_count() == 4002 && rows[1].size() == 4000;
+    for (unsigned c = 1; ok && c <= 4000; c += 999)
+        ok = std::string(rows[1][c - 1].value) == std::to_string(c) + std::string(1000, 'x') && rows[1][c - 1].refer.col == c;
+    check(ok && std::string(rows[2][0].value) == "3", "a row wider than many chunks", errors, "");
+}
+
+void test_number_type()
+{
+    // t="n" is passed through as stored, only numbers without a type get their number format
+    auto file = xlsx({R"(<sheetData><row r="1"><c r="A1" t="n" s="0"><v>1.5</v></c><c r="B1" s="0"><v>1.5</v></c>)"
+                      R"(<c r="C1" t="n" s="1"><v>0.25</v></c><c r="D1" s="1"><v>0.25</v></c><c r="E1" t="n" s="9"><v>3</v></c></row></sheetData>)"},
+                     "", R"(<xf numFmtId="2"/><xf numFmtId="10"/>)");
+    auto workbook = xlsxtext::workbook::from_memory(file.data(), file.size());
+    check(workbook.read(), "workbook read");
+    auto worksheet = workbook.worksheets()[0];
+    auto errors = dump(worksheet.read());
+    auto expected = "1: A1=1.5 B1=1.50 C1=0.25 D1=25.00% E1=3\n";
+    check(dump(worksheet) == expected && errors.empty(), "t=\"n\" cells", dump(worksheet) + errors, expected);
+
+    std::string raw;
+    worksheet.for_each_raw_row([&](const xlsxtext::raw_row_view &row)
+                               {
+                                   for (auto &cell : row)
+                                       raw += " " + cell.refer.value() + "=" + (cell.type == xlsxtext::raw_cell::type_number ? "" : "!") + cell.text(); });
+    check(raw == " A1=1.5 B1=1.50 C1=0.25 D1=25.00% E1=3", "t=\"n\" raw cells", raw, " A1=1.5 B1=1.50 C1=0.25 D1=25.00% E1=3");
+
+    std::string error;
+    auto value = workbook.read_value("1.5", "n", "0", error);
+    check(value == "1.5" && error.empty(), "read_value t=\"n\"", value + error, "1.5");
+    value = workbook.read_value("0.25", "", "1", error);
+    check(value == "25.00%" && error.empty(), "read_value without t", value + error, "25.00%");
+}
+
+void test_shared_string_hint()
+{
+    // a uniqueCount far beyond the part is not trusted for the allocation
+    for (auto count : {"4000000000", "4294967295", "0"})
+    {
+        auto file = xlsx({R"(<sheetData><row r="1"><c r="A1" t="s"><v>0</v></c><c r="B1" t="s"><v>1</v></c></row></sheetData>)"},
+                         std::string(R"(<sst uniqueCount=")") + count + R"("><si><t>a</t></si><si><t>b</t></si></sst>)");
+        auto workbook = xlsxtext::workbook::from_memory(file.data(), file.size());
+        check(workbook.read() && workbook.shared_string_count() == 2, std::string("uniqueCount ") + count);
+        auto worksheet = workbook.worksheets()[0];
+        worksheet.read();
+        check(dump(worksheet) == "1: A1=a B1=b\n", std::string("shared strings with uniqueCount ") + count, dump(worksheet), "1: A1=a B1=b\n");
+    }
+}
+
+void test_lazy_shared_strings()
+{
+    // decoding entries on first use gives the table read eagerly
+    std::string sst = R"(<sst count="9" uniqueCount="9"><si><t>plain</t></si><si><t xml:space="preserve">  spaced  </t></si>)"
+                      R"(<si><t>a &amp; b &lt;c&gt; &#x20AC;</t></si><si><r><t>ri</t></r><r><rPr><b/></rPr><t xml:space="preserve">ch </t></r></si>)"
+                      R"(<si/><si><t/></si><si><t>kept</t><rPh sb="0" eb="1"><t>ignored</t></rPh></si>)"
+                      R"(<si><t><![CDATA[<cdata>]]></t></si><si><t>line
+break</t></si></sst>)";
+    std::string rows = "<sheetData>";
+    for (unsigned r = 1; r <= 3; ++r)
+    {
+        rows += R"(<row r=")" + std::to_string(r) + R"(">)";
+        for (unsigned i = 0; i < 9; ++i)
+            rows += R"(<c t="s"><v>)" + std::to_string((i + r) % 9) + "</v></c>";
+        rows += "</row>";
+    }
+    rows += R"(<row r="4"><c r="A4" t="s"><v>9</v></c></row></sheetData>)";
+    auto file = xlsx({rows, rows}, sst);
+
+    auto eager = xlsxtext::workbook::from_memory(file.data(), file.size());
+    auto lazy = xlsxtext::workbook::from_memory(file.data(), file.size());
+    check(eager.read() && lazy.read(true), "workbook read");
+    check(eager.shared_string_count() == 9 && lazy.shared_string_count() == 9, "shared string count", std::to_string(lazy.shared_string_count()), "9");
+    for (size_t i = 0; i < 9 && i < lazy.shared_string_count(); ++i)
+        check(lazy.shared_string(i) == eager.shared_string(i), "shared string " + std::to_string(i), std::string(lazy.shared_string(i)), std::string(eager.shared_string(i)));
+
+    auto expected = eager.worksheets()[0];
+    auto errors = dump(expected.read());
+    check(errors == "A4 shared string index out of range\n", "index past the table", errors, "A4 shared string index out of range\n");
+    auto results = lazy.read_all(2);
+    for (size_t i = 0; i < results.size(); ++i)
+        check(dump(lazy.worksheets()[i]) == dump(expected) && dump(results[i]) == errors, "lazy sheet " + std::to_string(i + 1), dump(lazy.worksheets()[i]), dump(expected));
+}
+
+void test_sources()
+{
+    std::string sst = "<si><t>even</t></si><si><t>odd</t></si>";
+    auto file = xlsx({sheet_data(100), sheet_data(50)}, sst);
+    auto memory = xlsxtext::workbook::from_memory(file.data(), file.size());
+    check(memory.read() && memory.worksheets().size() == 2, "buffer read");
+    auto results = memory.read_all(2);
+    auto expected = dump(memory.worksheets()[0]) + dump(memory.worksheets()[1]);
+    check(results.size() == 2 && results[0].empty() && results[1].empty() && expected.find("2: A2=2.5 B2=even C2=row 2\n") != std::string::npos, "buffer sheets");
+
+    // a path and the memory map flag stay a path
+    const char *path = "worksheet.test.xlsx";
+    auto out = std::fopen(path, "wb");
+    check(out && std::fwrite(file.data(), 1, file.size(), out) == file.size() && std::fclose(out) == 0, "write file");
+    for (bool memory_map : {false, true})
+    {
+        xlsxtext::workbook workbook(path, memory_map);
+        check(workbook.read(), std::string("file read, memory_map ") + (memory_map ? "on" : "off"));
+        workbook.read_all(2);
+        check(workbook.worksheets().size() == 2 && dump(workbook.worksheets()[0]) + dump(workbook.worksheets()[1]) == expected, "file sheets");
+    }
+    std::remove(path);
+
+    // a read-at-offset callback, called from every reading thread
+    std::atomic<bool> fail{false};
+    std::atomic<size_t> calls{0};
+    xlsxtext::workbook remote([&](std::uint64_t offset, void *buffer, size_t size) -> size_t
+                              {
+                                  ++calls;
+                                  if (fail)
+                                      throw std::runtime_error("connection lost");
+                                  if (offset >= file.size())
+                                      return 0;
+                                  size = std::min<size_t>(size, file.size() - offset);
+                                  std::memcpy(buffer, file.data() + offset, size);
+                                  return size; },
+                              file.size());
+    check(remote.read() && calls > 0, "callback read");
+    results = remote.read_all(2);
+    check(results.size() == 2 && results[0].empty() && results[1].empty() && dump(remote.worksheets()[0]) + dump(remote.worksheets()[1]) == expected, "callback sheets");
+
+    // an exception thrown by the callback is a read failure, not an escaping exception
+    fail = true;
+    auto worksheet = remote.worksheets()[0];
+    std::string errors;
+    try
+    {
+        errors = dump(worksheet.read());
+    }
+    catch (...)
+    {
+        errors = "exception";
+    }
+    check(errors == "workseet open failed\n" && worksheet.rows().empty(), "callback throwing while reading a sheet", errors, "workseet open failed\n");
+    errors = dump(worksheet.read(2));
+    check(errors == "workseet open failed\n" && worksheet.rows().empty(), "callback throwing while reading a sheet with threads", errors, "workseet open failed\n");
+    try
+    {
+        results = remote.read_all(2);
+        errors = dump(results[0]) + dump(results[1]);
+    }
+    catch (...)
+    {
+        errors = "exception";
+    }
+    check(errors == "workseet open failed\nworkseet open failed\n", "callback throwing in read_all", errors, "");
+    try
+    {
+        errors = remote.read() ? "read" : "failed";
+    }
+    catch (...)
+    {
+        errors = "exception";
+    }
+    check(errors == "failed" && remote.worksheets().empty(), "callback throwing while opening", errors, "failed");
+
+    // so is a callback returning less than asked for
+    xlsxtext::workbook truncated([&](std::uint64_t offset, void *buffer, size_t size) -> size_t
+                                 {
+                                     if (offset >= file.size() / 2)
+                                         return 0;
+                                     size = std::min<size_t>(size, file.size() / 2 - offset);
+                                     std::memcpy(buffer, file.data() + offset, size);
+                                     return size; },
+                                 file.size());
+    check(!truncated.read(), "truncated callback");
+}
+
+void test_columns()
+{
+    // cells with and without r, a style error in a column left out and a row holding none of the columns
+    std::string rows = R"(<sheetData><row r="1"><c r="A1"><v>1</v></c><c r="B1" s="9"><v>2</v></c><c r="C1" t="inlineStr"><is><t>c1</t></is></c>)"
+                       R"(<c r="AB1" t="s"><v>0</v></c></row><row r="2"><c r="B2"><v>4</v></c><c r="D2"><v>5</v></c></row>)"
+                       R"(<row r="3"><c><v>7</v></c><c><v>8</v></c><c><v>9</v></c></row><row r="4"><c r="C4" s="9"><v>6</v></c></row>)";
+    for (unsigned r = 5; r <= 40000; ++r)
+    {
+        auto n = std::to_string(r);
+        rows += R"(<row r=")" + n + R"("><c r="A)" + n + R"("><v>)" + n + R"(</v></c><c r="B)" + n + R"("><v>0</v></c><c r="C)" + n + R"(" t="s"><v>0</v></c></row>)";
+    }
+    auto file = xlsx({rows + "</sheetData>"}, "<si><t>shared</t></si>");
+    auto workbook = xlsxtext::workbook::from_memory(file.data(), file.size());
+    check(workbook.read(), "workbook read");
+    auto worksheet = workbook.worksheets()[0];
+
+    auto errors = dump(worksheet.read(xlsxtext::columns{"A", "C", "AB"}));
+    auto expected = dump(worksheet);
+    std::string head = "1: A1=1 C1=c1 AB1=shared\n3: A3=7 C3=9\n4: C4=6\n5: A5=5 C5=shared\n";
+    check(expected.compare(0, head.size(), head) == 0, "columns by name", expected.substr(0, head.size()), head);
+    check(errors == "C4 style index out of range\n", "errors of the projected columns only", errors, "C4 style index out of range\n");
+    check(worksheet.rows().size() == 40000 - 1 && worksheet.rows().cell_count() == 2 * 39996 + 6, "projected cell count");
+
+    // the same projection by number, streamed, typed and read by several threads
+    check(dump(worksheet.read(xlsxtext::columns{1, 3, 28})) == errors && dump(worksheet) == expected, "columns by number");
+    std::string streamed, raw;
+    worksheet.for_each_row([&](const xlsxtext::row_view &row)
+                           {
+                               streamed += std::to_string(row.index()) + ":";
+                               for (auto &cell : row)
+                                   streamed += " " + cell.refer.value() + "=" + cell.value;
+                               streamed += "\n"; },
+                           xlsxtext::columns{"A", "C", "AB"});
+    check(streamed == expected, "for_each_row with columns");
+    worksheet.for_each_raw_row([&](const xlsxtext::raw_row_view &row)
+                               {
+                                   raw += std::to_string(row.index()) + ":";
+                                   for (auto &cell : row)
+                                       raw += " " + cell.refer.value() + "=" + cell.text();
+                                   raw += "\n"; },
+                               xlsxtext::columns{"A", "C", "AB"});
+    check(raw == expected, "for_each_raw_row with columns");
+    check(dump(worksheet.read(4, xlsxtext::columns{"A", "C", "AB"})) == errors && dump(worksheet) == expected, "parallel read with columns");
+
+    // no column given: every column; only invalid columns: none, nothing beyond XFD
+    auto all = dump(worksheet.read());
+    check(dump(worksheet).compare(0, 30, "1: A1=1 B1=2 C1=c1 AB1=shared\n") == 0 && all == "B1 style index out of range\nC4 style index out of range\n", "all columns", all, "");
+    check(worksheet.read(xlsxtext::columns{"a", "A1", ""}).empty() && worksheet.rows().size() == 0, "invalid column names read no cell",
+          std::to_string(worksheet.rows().cell_count()), "0");
+    worksheet.read(xlsxtext::columns{0u});
+    check(worksheet.rows().size() == 0, "column 0 reads no cell", std::to_string(worksheet.rows().cell_count()), "0");
+    worksheet.read(xlsxtext::columns{"XFE"});
+    check(worksheet.rows().size() == 0, "a column past XFD reads no cell", std::to_string(worksheet.rows().cell_count()), "0");
+    check(xlsxtext::columns{}.empty() && !xlsxtext::columns{"a"}.empty() && !xlsxtext::columns{"a"}.contains(1), "an invalid projection is not empty");
+    worksheet.read(xlsxtext::columns{"XFE", "ZZZZZZZZZ", "B"});
+    check(worksheet.rows().cell_count() == 39996 + 3, "columns past XFD are ignored", std::to_string(worksheet.rows().cell_count()), "");
+}
+
+void test_row_range()
+{
+    auto file = xlsx({sheet_data(10)}, "<si><t>even</t></si><si><t>odd</t></si>");
+    auto workbook = xlsxtext::workbook::from_memory(file.data(), file.size());
+    check(workbook.read(), "workbook read");
+    auto worksheet = workbook.worksheets()[0];
+
+    // braces are columns and a number is threads, a range is always named
+    worksheet.read({1, 3});
+    check(worksheet.rows().size() == 10 && worksheet.rows().cell_count() == 20, "read({1, 3}) reads columns");
+    worksheet.read(5);
+    check(worksheet.rows().size() == 10 && worksheet.rows().cell_count() == 30, "read(5) reads all rows");
+    worksheet.read(xlsxtext::row_range::rows(3, 4));
+    check(dump(worksheet) == "3: A3=3.5 B3=odd C3=row 3\n4: A4=4.5 B4=even C4=row 4\n", "rows 3 to 4", dump(worksheet), "");
+    worksheet.read(xlsxtext::row_range::rows(2, 9, 2), {2});
+    check(dump(worksheet) == "2: B2=even\n3: B3=odd\n", "at most 2 rows from row 2", dump(worksheet), "");
+    worksheet.read(xlsxtext::row_range::head(1));
+    check(dump(worksheet) == "1: A1=1.5 B1=odd C1=row 1\n", "head", dump(worksheet), "");
+}
+
+void test_statistics()
+{
+    // rows cut at the end of a 64 KiB piece are parsed again but counted once
+    std::string rows = "<sheetData>";
+    for (unsigned r = 1; r <= 30000; ++r)
+    {
+        auto n = std::to_string(r);
+        rows += R"(<row r=")" + n + R"("><c r="A)" + n + R"(" s="1"><v>)" + n + R"(.25</v></c><c r="B)" + n + R"(" t="s"><v>0</v></c><c r="C)" + n +
+                R"(" t="inlineStr"><is><t>row )" + n + "</t></is></c></row>";
+    }
+    auto file = xlsx({rows + "</sheetData>"}, "<si><t>shared</t></si>", R"(<xf numFmtId="0"/><xf numFmtId="2"/>)");
+    check(file.size() > 0 && rows.size() > 20 * 64 * 1024, "sheet spans many pieces");
+    auto workbook = xlsxtext::workbook::from_memory(file.data(), file.size());
+    check(workbook.read(), "workbook read");
+    auto worksheet = workbook.worksheets()[0];
+    for (int mode = 0; mode < 3; ++mode)
+    {
+        xlsxtext::statistics stats;
+        workbook.collect_statistics(&stats);
+        if (mode == 0)
+            worksheet.read();
+        else if (mode == 1)
+            worksheet.read(2);
+        else
+            worksheet.for_each_raw_row([](const xlsxtext::raw_row_view &) {});
+        workbook.collect_statistics(nullptr);
+        auto name = std::string("statistics of ") + (mode == 0 ? "read()" : mode == 1 ? "read(2)" : "for_each_raw_row");
+        auto cells = std::to_string(stats.cells[xlsxtext::statistics::cell_number]) + " " + std::to_string(stats.cells[xlsxtext::statistics::cell_shared_string]) + " " +
+                     std::to_string(stats.cells[xlsxtext::statistics::cell_inline_string]) + " " + std::to_string(stats.rows);
+        check(cells == "30000 30000 30000 30000", name + ": cells and rows", cells, "30000 30000 30000 30000");
+        auto hits = std::to_string(stats.format_hits) + " " + std::to_string(stats.format_misses);
+        auto expected = mode == 2 ? "0 0" : "30000 0"; // typed cells are not formatted
+        check(hits == expected, name + ": format hits and misses", hits, expected);
+    }
+}
+
+static xlsxtext::merge_range range(const char *first, const char *last)
+{
+    return {xlsxtext::reference(first), xlsxtext::reference(last)};
+}
+
+void test_merge_index()
+{
+    // adjacent, overlapping, nested, single row and single column ranges
+    std::vector<xlsxtext::merge_range> ranges{range("A1", "B2"), range("C1", "D2"), range("A3", "D3"), range("F1", "H8"),
+                                              range("G4", "J6"), range("F10", "F20"), range("B12", "D14"), range("C13", "C13")};
+    xlsxtext::merge_index index(ranges);
+    check(index.size() == ranges.size(), "merge_index size");
+    std::string result, expected;
+    for (unsigned row = 0; row <= 22; ++row)
+        for (unsigned col = 0; col <= 12; ++col)
+        {
+            auto found = index.find(row, col);
+            bool covered = false;
+            for (auto &range : ranges)
+                covered = covered || range.contains(row, col);
+            if ((found != nullptr) != covered || (found && !found->contains(row, col)))
+                result += xlsxtext::reference(row, col).value() + " ";
+        }
+    check(result.empty(), "merge_index finds a covering range for every covered cell only", result, "");
+    auto at = [&](const char *refer)
+    {
+        auto found = index.find(xlsxtext::reference(refer));
+        return found ? found->first.value() + ":" + found->last.value() : std::string("-");
+    };
+    result = at("B2") + " " + at("C1") + " " + at("D3") + " " + at("E3") + " " + at("I5") + " " + at("F21") + " " + at("XFD1048576");
+    expected = "A1:B2 C1:D2 A3:D3 - G4:J6 - -";
+    check(result == expected, "merge_index adjacent ranges", result, expected);
+
+    // many random ranges against a linear search
+    std::mt19937 random(7);
+    ranges.clear();
+    for (int i = 0; i < 300; ++i)
+    {
+        unsigned row = random() % 200 + 1, col = random() % 30 + 1;
+        ranges.push_back({xlsxtext::reference(row, col), xlsxtext::reference(row + random() % 8, col + random() % 4)});
+    }
+    index = xlsxtext::merge_index(ranges);
+    size_t wrong = 0;
+    for (unsigned row = 1; row <= 210; ++row)
+        for (unsigned col = 1; col <= 36; ++col)
+        {
+            auto found = index.find(row, col);
+            bool covered = false;
+            for (auto &range : ranges)
+                covered = covered || range.contains(row, col);
+            wrong += (found != nullptr) != covered || (found && !found->contains(row, col));
+        }
+    check(wrong == 0, "merge_index random ranges", std::to_string(wrong), "0");
+    check(xlsxtext::merge_index().find(1, 1) == nullptr, "empty merge_index");
+}
+
+void test_fill_merged_cells()
+{
+    auto filled = [](const std::string &rows, const std::string &merges)
+    {
+        auto file = xlsx({"<sheetData>" + rows + "</sheetData><mergeCells>" + merges + "</mergeCells>"});
+        auto workbook = xlsxtext::workbook::from_memory(file.data(), file.size());
+        workbook.read();
+        auto worksheet = workbook.worksheets()[0];
+        worksheet.read();
+        worksheet.fill_merged_cells();
+        std::string out;
+        for (auto row : worksheet)
+        {
+            out += std::to_string(row.index()) + ":";
+            for (auto cell : row)
+                out += " " + cell.refer.value() + "=" + std::string(cell.value);
+            out += row.empty() ? " (empty)\n" : "\n";
+        }
+        return out;
+    };
+    auto merge = [](const char *ref)
+    { return std::string(R"(<mergeCell ref=")") + ref + R"("/>)"; };
+    auto test = [&](const std::string &name, const std::string &rows, const std::string &merges, const std::string &expected)
+    {
+        auto result = filled(rows, merges);
+        check(result == expected, "fill_merged_cells " + name, result, expected);
+    };
+
+    // adjacent ranges, the anchor of each filled into its own cells only
+    test("adjacent", R"(<row r="1"><c r="A1"><v>1</v></c><c r="C1"><v>2</v></c><c r="E1"><v>9</v></c></row><row r="2"><c r="E2"><v>8</v></c></row>)",
+         merge("A1:B2") + merge("C1:D2"),
+         "1: A1=1 B1=1 C1=2 D1=2 E1=9\n2: A2=1 B2=1 C2=2 D2=2 E2=8\n");
+
+    // overlapping ranges: a cell covered twice takes the range starting further left
+    test("overlapping", R"(<row r="1"><c r="A1"><v>a</v></c></row><row r="2"><c r="B2"><v>b</v></c><c r="D2"><v>x</v></c></row><row r="3"><c r="E3"><v>e</v></c></row>)",
+         merge("A1:C3") + merge("B2:D3"),
+         "1: A1=a B1=a C1=a\n2: A2=a B2=a C2=a D2=b\n3: A3=a B3=a C3=a D3=b E3=e\n");
+
+    // row gaps: missing rows inside a range are created, rows between ranges are not
+    test("row gaps", R"(<row r="2"><c r="B2"><v>x</v></c></row><row r="10"><c r="A10"><v>y</v></c><c r="C10"><v>z</v></c></row>)"
+                     R"(<row r="20"><c r="A20"><v>w</v></c></row>)",
+         merge("B2:C4") + merge("A10:A12"),
+         "2: B2=x C2=x\n3: B3=x C3=x\n4: B4=x C4=x\n10: A10=y C10=z\n11: A11=y\n12: A12=y\n20: A20=w\n");
+
+    // ranges past the used area are cut at the last row and column holding a cell, no empty row is left behind
+    test("past the used area", R"(<row r="1"><c r="A1"><v>1</v></c><c r="C1"><v>3</v></c></row><row r="3"><c r="B3"><v>5</v></c></row>)",
+         merge("A1:A1000") + merge("C1:XFD2") + merge("E5:F6") + merge("B3:B3"),
+         "1: A1=1 C1=3\n2: A2=1 C2=3\n3: A3=1 B3=5\n");
+    test("ending above the next row", R"(<row r="1"><c r="A1"><v>1</v></c></row><row r="9"><c r="B9"><v>2</v></c></row>)",
+         merge("A1:B2"),
+         "1: A1=1 B1=1\n2: A2=1 B2=1\n9: B9=2\n");
+
+    // an empty or missing anchor fills nothing
+    test("without anchor", R"(<row r="1"><c r="A1"/><c r="B1"><v>1</v></c></row><row r="2"><c r="B2"><v>2</v></c></row>)",
+         merge("A1:A2") + merge("C1:C2"),
+         "1: A1= B1=1\n2: B2=2\n");
+}
+
+void test_error_values()
+{
+    auto file = xlsx({R"(<sheetData><row r="1"><c r="A1" t="e"><v>#N/A</v></c><c r="B1" t="e"><v>#FOO</v></c><c r="C1" t="e"/>)"
+                      R"(<c r="D1" t="e"><f>1/0</f><v>#DIV/0!</v></c><c r="E1" t="e"><v>#SPILL!</v></c></row></sheetData>)"});
+    auto workbook = xlsxtext::workbook::from_memory(file.data(), file.size());
+    check(workbook.read(), "workbook read");
+    auto worksheet = workbook.worksheets()[0];
+    auto errors = worksheet.read();
+    auto result = dump(errors);
+    auto expected = "A1 #N/A\nB1 unknown error value\nC1 cell error\nE1 #SPILL!\n";
+    check(result == expected, "error values", result, expected);
+    check(dump(worksheet) == "1: A1=#N/A B1=#FOO C1=#ERROR! D1=#DIV/0! E1=#SPILL!\n", "error cells", dump(worksheet), "");
+
+    // a value Excel does not define is counted on its own and can still be fetched from its cell
+    check(errors.count(xlsxtext::read_error::error_other) == 1 && errors.count(xlsxtext::read_error::cell_error) == 1, "error_other count");
+    std::string other;
+    for (auto &error : errors)
+        if (error.code == xlsxtext::read_error::error_other)
+            other += error.refer().value() + "=" + std::string(worksheet.at(error.refer()).value);
+    check(other == "B1=#FOO", "error_other value", other, "B1=#FOO");
+    check(dump(worksheet.for_each_raw_row([](const xlsxtext::raw_row_view &) {})) == expected, "error values of raw rows");
+
+    std::string error;
+    workbook.read_value("#FOO", "e", "", error);
+    check(error == "#FOO", "read_value message of an unknown error value", error, "#FOO");
+    check(xlsxtext::read_error::cell_error_code("#FOO") == xlsxtext::read_error::error_other &&
+              xlsxtext::read_error::cell_error_code("") == xlsxtext::read_error::cell_error &&
+              xlsxtext::read_error::cell_error_code("#CALC!") == xlsxtext::read_error::error_calc,
+          "cell_error_code");
+}
+
+int main()
+{
+#ifdef _WIN32
+    auto __con_out_cp = GetConsoleOutputCP();
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    std::cout << "=== worksheet Tests ===" << std::endl
+              << std::endl;
+
+    test_split_rows();
+    test_parallel_read();
+    test_wide_row();
+    test_number_type();
+    test_shared_string_hint();
+    test_lazy_shared_strings();
+    test_sources();
+    test_columns();
+    test_row_range();
+    test_statistics();
+    test_merge_index();
+    test_fill_merged_cells();
+    test_error_values();
+
+    std::cout << std::endl;
+    std::cout << "=== Test Summary ===" << std::endl;
+    std::cout << "Passed: " << total.passed << std::endl;
+    std::cout << "Failed: " << total.failed << std::endl;
+    std::cout << "Total:  " << (total.passed + total.failed) << std::endl;
+
+    if (total.failed == 0)
+        std::cout << "\n*** ALL TESTS PASSED ***" << std::endl;
+    else
+        std::cout << "\n*** " << total.failed << " TEST(S) FAILED ***" << std::endl;
+
+#ifdef _WIN32
+    SetConsoleOutputCP(__con_out_cp);
+#endif
+    return total.failed == 0 ? 0 : 1;
+}
@@ -28,8 +28,8 @@ int main()
         try
         {
             auto errors = worksheet.read();
-            for (auto kv : errors)
-                std::cerr << kv.first << ": " << kv.second << std::endl;
+            for (auto &error : errors)
+                std::cerr << (error.row ? error.refer().value() : worksheet.name()) << ": " << error.message() << std::endl;
 
             std::cout << std::endl;
             for (auto row : worksheet)
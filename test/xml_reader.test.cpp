@@ -0,0 +1,276 @@
+#include <xlsxtext.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+struct test_result
+{
+    int passed = 0;
+    int failed = 0;
+};
+
+static test_result total;
+
+static void check(bool pass, const std::string &name, const std::string &result = "", const std::string &expected = "")
+{
+    if (pass)
+    {
+        total.passed++;
+        return;
+    }
+    total.failed++;
+    std::cout << "[FAIL] " << name;
+    if (!result.empty() || !expected.empty())
+        std::cout << " => got: \"" << result << "\", expected: \"" << expected << "\"";
+    std::cout << std::endl;
+}
+
+/**
+ * The nodes of xml as one line: <name attributes>, </name>, [text] (decoded, adjacent text nodes joined) or !malformed.
+ * The buffer is fed in chunks of chunk bytes (0: at once), resuming at position() after every node_end as the sheet
+ * reader does.
+ */
+static std::string nodes(const std::string &xml, size_t chunk = 0)
+{
+    std::string out, text;
+    auto flush = [&]
+    {
+        if (!text.empty())
+            out += "[" + text + "]";
+        text.clear();
+    };
+    size_t begin = 0, end = chunk ? std::min(chunk, xml.size()) : xml.size();
+    for (;;)
+    {
+        bool final = end == xml.size();
+        xlsxtext::xml_reader reader(xml.data() + begin, xml.data() + end, final);
+        auto consumed = reader.position();
+        for (;;)
+        {
+            auto node = reader.next();
+            if (node == xlsxtext::xml_reader::node_end)
+                break;
+            if (node == xlsxtext::xml_reader::node_malformed)
+            {
+                flush();
+                return out + "!malformed";
+            }
+            if (node == xlsxtext::xml_reader::node_text)
+            {
+                // text at the end of a piece may continue in the next one, it is consumed only once complete
+                if (!final && reader.position() == xml.data() + end)
+                    break;
+                reader.text(text);
+            }
+            else
+            {
+                flush();
+                if (node == xlsxtext::xml_reader::node_end_element)
+                    out += "</" + std::string(reader.name()) + ">";
+                else
+                {
+                    out += "<" + std::string(reader.name());
+                    for (auto name : {"r", "t", "s", "a"})
+                        if (!reader.attribute(name).empty())
+                            out += std::string(" ") + name + "=" + std::string(reader.attribute(name));
+                    out += reader.empty_element() ? "/>" : ">";
+                }
+            }
+            consumed = reader.position();
+        }
+        if (final)
+            break;
+        begin = consumed - xml.data();
+        end = std::min(end + chunk, xml.size());
+    }
+    flush();
+    return out;
+}
+
+/**
+ * Text of the first element of xml as read by read_text.
+ */
+static std::string read_text(const std::string &xml)
+{
+    xlsxtext::xml_reader reader(xml.data(), xml.data() + xml.size());
+    std::string out;
+    if (reader.next() != xlsxtext::xml_reader::node_element || !reader.read_text(out))
+        return "!malformed";
+    return out;
+}
+
+static std::string read_rich_text(const std::string &xml)
+{
+    xlsxtext::xml_reader reader(xml.data(), xml.data() + xml.size());
+    std::string out;
+    if (reader.next() != xlsxtext::xml_reader::node_element || !reader.read_rich_text(out))
+        return "!malformed";
+    return out;
+}
+
+static void check_nodes(const std::string &xml, const std::string &expected)
+{
+    auto result = nodes(xml);
+    check(result == expected, "nodes " + xml, result, expected);
+}
+
+static void check_text(const std::string &xml, const std::string &expected)
+{
+    auto result = read_text(xml);
+    check(result == expected, "read_text " + xml, result, expected);
+}
+
+void test_nodes()
+{
+    // elements, self-closing elements and attributes quoted either way
+    check_nodes("<a><b/><c r=\"A1\" t='s'>x</c></a>", "<a><b/><c r=A1 t=s>[x]</c></a>");
+    check_nodes("<c r='A1' s=\"2\"/>", "<c r=A1 s=2/>");
+    check_nodes("<c r = \"A1\" />", "<c r=A1/>");
+    check_nodes("<c a=\"x>y\" r='B2'>1</c>", "<c r=B2 a=x>y>[1]</c>");
+    check_nodes("<c a='say \"hi\"'/>", "<c a=say \"hi\"/>");
+    check_nodes("<x:c r=\"A1\"/>", "<x:c r=A1/>");
+
+    // entities and character references
+    check_nodes("<t>&lt;&gt;&amp;&quot;&apos;</t>", "<t>[<>&\"']</t>");
+    check_nodes("<t>&#65;&#x42;&#x43;&#228;&#x20AC;&#x1F600;</t>", "<t>[ABC\xC3\xA4\xE2\x82\xAC\xF0\x9F\x98\x80]</t>");
+    check_nodes("<t>&unknown; &#xZZ; &#; a & b</t>", "<t>[&unknown; &#xZZ; &#; a & b]</t>");
+    check_nodes("<t>a\r\nb\rc</t>", "<t>[a\nb\nc]</t>");
+
+    // CDATA is kept as is
+    check_nodes("<t><![CDATA[<b>&amp;]]></t>", "<t>[<b>&amp;]</t>");
+    check_nodes("<t>a<![CDATA[]]]]>b</t>", "<t>[a]]b]</t>");
+
+    // comments, processing instructions and declarations are skipped
+    check_nodes("<?xml version=\"1.0\"?><!DOCTYPE x><a><!-- <b> --><?pi x?>1</a>", "<a>[1]</a>");
+    check_nodes("<a><!-- a -- b -->2</a>", "<a>[2]</a>");
+
+    // broken markup
+    check_nodes("<a><b", "<a>!malformed");
+    check_nodes("<a><!-- x", "<a>!malformed");
+    check_nodes("<a><![CDATA[x", "<a>!malformed");
+    check_nodes("<a>< b/></a>", "<a>!malformed");
+    check_nodes("<a c=\"1></a>", "!malformed");
+}
+
+void test_text()
+{
+    // the first CDATA section or character data that is not only whitespace, as pugixml's text()
+    check_text("<v>1.5</v>", "1.5");
+    check_text("<v/>", "");
+    check_text("<v></v>", "");
+    check_text("<v> 1 </v>", " 1 ");
+    check_text("<v>  </v>", "");
+    check_text("<t xml:space=\"preserve\">  </t>", "");
+    check_text("<t xml:space=\"preserve\"> a  b </t>", " a  b ");
+    check_text("<t>\n  <![CDATA[ ]]>x</t>", " ");
+    check_text("<v>1<!-- c -->2</v>", "1");
+    check_text("<v><x>9</x>3</v>", "3");
+    check_text("<v>a&amp;b</v>", "a&b");
+
+    // rich text: the runs joined, or the first t
+    auto rich = [](const std::string &xml, const std::string &expected)
+    {
+        auto result = read_rich_text(xml);
+        check(result == expected, "read_rich_text " + xml, result, expected);
+    };
+    rich("<is><t>text</t></is>", "text");
+    rich("<si><r><t>te</t></r><r><rPr><b/></rPr><t xml:space=\"preserve\">xt </t></r></si>", "text ");
+    rich("<si><t>a</t><t>b</t></si>", "a");
+    rich("<si><t>a</t><r><t>b</t></r></si>", "b");
+    rich("<si><rPh><t>ignored</t></rPh><t>kept</t></si>", "kept");
+    rich("<si/>", "");
+}
+
+void test_chunks()
+{
+    // every node sequence must be the same whatever the chunk boundaries
+    std::string xml = "<?xml version=\"1.0\"?>\n<worksheet><sheetData>"
+                      "<row r=\"1\" spans=\"1:3\"><c r=\"A1\" t='inlineStr'><is><t xml:space=\"preserve\"> a &amp; b </t></is></c>"
+                      "<c r=\"B1\"><v>12345.678</v></c><!-- comment > x --><c r=\"C1\" t=\"s\"><v>0</v></c></row>"
+                      "<row r=\"2\"><c r=\"A2\"><f>SUM(A1:A1)</f><v>1</v></c><c r=\"B2\" t=\"str\"><v><![CDATA[<&>]]></v></c></row>"
+                      "</sheetData><mergeCells count=\"1\"><mergeCell ref=\"A1:B2\"/></mergeCells></worksheet>";
+    auto expected = nodes(xml);
+    for (size_t chunk = 1; chunk <= xml.size(); ++chunk)
+    {
+        auto result = nodes(xml, chunk);
+        check(result == expected, "chunks of " + std::to_string(chunk), result, expected);
+    }
+
+    // and so must the rows of the sheet reader, fed in pieces as worksheet::read does
+    xlsxtext::workbook workbook("");
+    auto rows = [&](size_t chunk)
+    {
+        xlsxtext::read_errors errors;
+        std::vector<xlsxtext::merge_range> merges;
+        xlsxtext::sheet_dimension dimension;
+        xlsxtext::sheet_reader reader(workbook, errors, merges, dimension);
+        std::string out, pending;
+        size_t consumed = 0, offset = 0;
+        auto on_row = [&](unsigned index, std::vector<xlsxtext::cell> &cells)
+        {
+            out += std::to_string(index) + ":";
+            for (auto &cell : cells)
+                out += " " + cell.refer.value() + "=" + cell.value;
+            out += "\n";
+            return true;
+        };
+        for (;;)
+        {
+            pending.erase(0, consumed);
+            auto size = std::min(chunk, xml.size() - offset);
+            pending.append(xml, offset, size);
+            offset += size;
+            consumed = reader.feed(pending.data(), pending.size(), size == 0, on_row);
+            if (size == 0 || reader.done())
+                break;
+        }
+        if (reader.failed())
+            out += "!failed";
+        for (auto &merge : merges)
+            out += merge.first.value() + ":" + merge.last.value();
+        return out;
+    };
+    auto whole = rows(xml.size() + 1);
+    check(whole == "1: A1= a & b  B1=12345.678 C1=\n2: A2=1 B2=<&>\nA1:B2", "sheet reader rows", whole, "");
+    for (size_t chunk = 1; chunk <= xml.size(); ++chunk)
+    {
+        auto result = rows(chunk);
+        check(result == whole, "sheet reader chunks of " + std::to_string(chunk), result, whole);
+    }
+}
+
+int main()
+{
+#ifdef _WIN32
+    auto __con_out_cp = GetConsoleOutputCP();
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    std::cout << "=== xml_reader Tests ===" << std::endl
+              << std::endl;
+
+    test_nodes();
+    test_text();
+    test_chunks();
+
+    std::cout << std::endl;
+    std::cout << "=== Test Summary ===" << std::endl;
+    std::cout << "Passed: " << total.passed << std::endl;
+    std::cout << "Failed: " << total.failed << std::endl;
+    std::cout << "Total:  " << (total.passed + total.failed) << std::endl;
+
+    if (total.failed == 0)
+        std::cout << "\n*** ALL TESTS PASSED ***" << std::endl;
+    else
+        std::cout << "\n*** " << total.failed << " TEST(S) FAILED ***" << std::endl;
+
+#ifdef _WIN32
+    SetConsoleOutputCP(__con_out_cp);
+#endif
+    return total.failed == 0 ? 0 : 1;
+}
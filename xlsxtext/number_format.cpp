@@ -7,8 +7,10 @@
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <numeric>
 #include <stdexcept>
+#include <string_view>
 #include <vector>
 
 namespace xlsxtext
@@ -224,11 +226,41 @@ namespace
     }
 
     // "General" format: shortest decimal representation via std::to_chars
-    std::string format_number_general(double number)
+    void append_number_general(std::string& out, double number)
     {
-        char buf[64]{};
+        char buf[64];
         auto r = std::to_chars(buf, buf + sizeof(buf), number);
-        return std::string(buf, r.ptr);
+        out.append(buf, r.ptr);
+    }
+
+    // Insert thousands separators between the digits of out[begin, end),
+    // every 3 digits from the right.  Non-digit characters (e.g., spaces
+    // from ? padding or literals between placeholders) are kept in place
+    // but not counted.  Works in place so no temporary string is needed.
+    void insert_thousands(std::string& out, size_t begin, size_t end)
+    {
+        int digit_count = 0;
+        for (size_t i = begin; i < end; ++i)
+            if (out[i] >= '0' && out[i] <= '9') ++digit_count;
+        if (digit_count <= 3) return;
+
+        const size_t commas = static_cast<size_t>(digit_count - 1) / 3;
+        out.insert(end, commas, ',');
+
+        // Walk right-to-left, shifting characters into the widened range
+        size_t write = end + commas;
+        int digits_seen = 0;
+        for (size_t read = end; read > begin;)
+        {
+            const char ch = out[--read];
+            out[--write] = ch;
+            if (ch >= '0' && ch <= '9')
+            {
+                ++digits_seen;
+                if (digits_seen % 3 == 0 && digits_seen < digit_count)
+                    out[--write] = ',';
+            }
+        }
     }
 
 } // anonymous namespace
@@ -311,20 +343,6 @@ struct number_format::impl
         std::string exp_pattern; // exponent digit pattern for scientific tokens
     };
 
-    // A format section — divided by ';' in the format string.
-    // Up to 4 sections: [positive]; [negative]; [zero]; [text]
-    struct section
-    {
-        std::vector<token> tokens;
-        bool has_condition = false;
-        enum cond_op : uint8_t { cond_none, cond_gt, cond_ge, cond_lt, cond_le, cond_eq, cond_ne };
-        cond_op condition_op = cond_none;
-        double condition_value = 0;
-        std::string color;              // [ColorName] bracket
-        int section_type = 0;           // 0=pos, 1=neg, 2=zero, 3=text
-        int scale = 1;                  // divisor from trailing commas (1, 1000, 1000000, ...)
-    };
-
     // Counts of digit placeholders (0, #, ?) on each side of the decimal point.
     // int_pattern records the L-to-R order of integer placeholder types ('0','#','?')
     // for correct zero-padding and suppression (e.g., "0#" differs from "#0").
@@ -366,6 +384,29 @@ struct number_format::impl
         fraction_layout frac_layout;
     };
 
+    // A format section — divided by ';' in the format string.
+    // Up to 4 sections: [positive]; [negative]; [zero]; [text]
+    struct section
+    {
+        std::vector<token> tokens;
+        bool has_condition = false;
+        enum cond_op : uint8_t { cond_none, cond_gt, cond_ge, cond_lt, cond_le, cond_eq, cond_ne };
+        cond_op condition_op = cond_none;
+        double condition_value = 0;
+        std::string color;              // [ColorName] bracket
+        int section_type = 0;           // 0=pos, 1=neg, 2=zero, 3=text
+        int scale = 1;                  // divisor from trailing commas (1, 1000, 1000000, ...)
+
+        // Compiled metadata — the token list is immutable after parse, so
+        // everything the formatters need is derived once by compile_section.
+        section_info info;
+        digit_counts digits;            // placeholders before the E token (scientific) or in the whole section
+        int sci_pos = -1;               // index of the scientific token, or -1
+        long long fixed_den = 0;        // fixed fraction denominator (e.g., 8 for "# ?/8"), or 0
+        bool owns_sign = false;         // section supplies "-" or "(" for negative values
+        double percent_scale = 1.0;     // 100 ^ percent_count
+    };
+
     // ---- data ----
 
     std::vector<section> sections;
@@ -487,6 +528,9 @@ struct number_format::impl
 
         // ECMA-376: 4th section is the text section (used when formatting strings)
         text_section_idx = (sections.size() >= 4) ? 3 : -1;
+
+        for (auto& sec : sections)
+            compile_section(sec);
     }
 
 private:
@@ -1200,6 +1244,54 @@ public:
     }
 
 private:
+    // Derive the per-section metadata used by format_double and the
+    // specialized formatters, so formatting never rescans the tokens.
+    static void compile_section(section& sec)
+    {
+        sec.info = analyze_section(sec);
+
+        for (size_t i = 0; i < sec.tokens.size(); ++i)
+            if (sec.tokens[i].type == token_type::scientific) { sec.sci_pos = static_cast<int>(i); break; }
+
+        sec.digits = count_digit_placeholders(sec, sec.info.has_scientific ? sec.sci_pos : -1);
+        // ECMA-376: "When a number format includes the comma as a thousands
+        // separator and also includes an exponent (E+, E-, e+, or e-
+        // designator), the format shall be treated as if a thousands separator
+        // were not present."
+        if (sec.info.has_scientific) sec.digits.thousands = 0;
+
+        if (sec.info.is_fraction)
+            sec.fixed_den = compute_fixed_denominator(sec, sec.info.frac_layout);
+
+        // Check if the section provides its own sign for negative numbers.
+        // ECMA-376: If the section begins with "-" or "(" (possibly preceded by
+        // skip/fill tokens like "_(*"), the section owns the sign and no automatic
+        // minus is prepended.  This applies to the actually selected section for
+        // a negative value, regardless of its index (important when conditional
+        // sections reorder the effective negative section).
+        //
+        // Implementation note: in addition to skip/fill tokens, we also skip
+        // non-sign literals (e.g., "$") before the first digit placeholder.
+        // ECMA-376 is strict about "begins with" but Excel recognizes "-" or "("
+        // anywhere before the digits in the negative section (e.g., "$-0" works).
+        // This relaxation matches Excel behavior.
+        for (auto& tok : sec.tokens)
+        {
+            if (tok.type == token_type::skip || tok.type == token_type::fill)
+                continue;
+            if (tok.type == token_type::literal)
+            {
+                if (tok.literal == "-" || tok.literal == "(")
+                { sec.owns_sign = true; break; }
+                continue;
+            }
+            break; // first non-literal, non-skip, non-fill → digit or other
+        }
+
+        if (sec.info.percent_count > 0)
+            sec.percent_scale = std::pow(100.0, sec.info.percent_count);
+    }
+
     // A digit token is a fraction denominator if it follows "/" and
     // there is a digit before the "/" (the numerator).
     static bool is_fraction_denominator(const std::vector<token>& tokens, size_t pos) noexcept
@@ -1235,18 +1327,18 @@ public:
     // format: double — main entry point
     // =========================================================================
 
-    std::string format_double(double number, bool date1904) const
+    void format_double(std::string& out, double number, bool date1904) const
     {
         // ECMA-376: NaN and INF both display as #NUM!
-        if (std::isnan(number) || std::isinf(number)) return "#NUM!";
+        if (std::isnan(number) || std::isinf(number)) { out += "#NUM!"; return; }
 
         if (is_general || sections.empty())
-            return format_number_general(number);
+            return append_number_general(out, number);
 
         const section* sec = select_section(number);
         // ECMA-376: "If the cell value does not meet any of the criteria, then
         // pound signs ("#") are displayed across the width of the cell."
-        if (!sec) return std::string(default_cell_width, '#');
+        if (!sec) { out.append(default_cell_width, '#'); return; }
 
         // ECMA-376: empty sections fall back to the first section's format.
         // If the first section is also empty (e.g., condition-only section),
@@ -1260,68 +1352,36 @@ public:
                     if (!s.tokens.empty()) { sec = &s; break; }
         }
 
-        const section_info info = analyze_section(*sec);
+        const section_info& info = sec->info;
 
         // No digit or date/time tokens → pure literal template (handles text sections with @)
         if (!info.has_digits && !info.has_date_time)
-            return render_literal_template(*sec, number);
-
-        // Check if the selected section provides its own sign for negative numbers.
-        // ECMA-376: If the section begins with "-" or "(" (possibly preceded by
-        // skip/fill tokens like "_(*"), the section owns the sign and no automatic
-        // minus is prepended.  This applies to the actually selected section for
-        // this negative value, regardless of its index (important when conditional
-        // sections reorder the effective negative section).
-        //
-        // Implementation note: in addition to skip/fill tokens, we also skip
-        // non-sign literals (e.g., "$") before the first digit placeholder.
-        // ECMA-376 is strict about "begins with" but Excel recognizes "-" or "("
-        // anywhere before the digits in the negative section (e.g., "$-0" works).
-        // This relaxation matches Excel behavior.
-        bool neg_section_owns_sign = false;
-        if (number < 0)
-        {
-            for (auto& tok : sec->tokens)
-            {
-                if (tok.type == token_type::skip || tok.type == token_type::fill)
-                    continue;
-                // Literal tokens before the digits: if "-" or "(" is found
-                // anywhere before the first digit placeholder, the section
-                // owns the sign (ECMA-376: "to the left of the digit
-                // placeholder").  Non-sign literals (e.g., "$") are skipped.
-                if (tok.type == token_type::literal)
-                {
-                    if (tok.literal == "-" || tok.literal == "(")
-                    { neg_section_owns_sign = true; break; }
-                    continue;
-                }
-                break; // first non-literal, non-skip, non-fill → digit or other
-            }
-        }
+            return render_literal_template(out, *sec, number);
 
         // ECMA-376: negative dates/times are not valid — display as "###########"
         if (number < 0 && info.has_date_time)
-            return std::string(default_cell_width, '#');
+        { out.append(default_cell_width, '#'); return; }
+
+        const bool neg_section_owns_sign = number < 0 && sec->owns_sign;
 
         // Dispatch to the appropriate specialized formatter
-        if (info.has_date_time)  return format_date_time_section(*sec, std::fabs(number), date1904, info.has_ampm);
-        if (info.is_fraction)    return format_fraction_section(*sec, info, number, neg_section_owns_sign, info.percent_count);
-        if (info.has_scientific) return format_scientific_section(*sec, number, neg_section_owns_sign, info.percent_count);
+        if (info.has_date_time)  return format_date_time_section(out, *sec, std::fabs(number), date1904, info.has_ampm);
+        if (info.is_fraction)    return format_fraction_section(out, *sec, number, neg_section_owns_sign);
+        if (info.has_scientific) return format_scientific_section(out, *sec, number, neg_section_owns_sign);
 
-        return format_regular_number_section(*sec, number, neg_section_owns_sign, info.percent_count);
+        return format_regular_number_section(out, *sec, number, neg_section_owns_sign);
     }
 
 private:
     // Render a section that has no digit or date/time tokens — just literals,
     // text placeholders, skip tokens, and other non-digit tokens that should
     // appear as their literal equivalents.
-    static std::string render_literal_template(const section& sec, double number)
+    static void render_literal_template(std::string& result, const section& sec, double number)
     {
-        std::string result;
         for (auto& tok : sec.tokens)
         {
             if (tok.type == token_type::text_placeholder)
-                result += format_number_general(number);
+                append_number_general(result, number);
             else if (append_common_token(result, tok))
                 continue;
             else
@@ -1344,7 +1404,6 @@ private:
                 }
             }
         }
-        return result;
     }
 
 public:
@@ -1389,7 +1448,7 @@ public:
     // format: date/time section
     // =========================================================================
 
-    std::string format_date_time_section(const section& sec, double raw_value, bool date1904, bool has_ampm) const
+    void format_date_time_section(std::string& result, const section& sec, double raw_value, bool date1904, bool has_ampm) const
     {
         const date_parts dp = serial_to_date(raw_value, date1904);
         const size_t month_idx = static_cast<size_t>(dp.month) - 1;
@@ -1406,9 +1465,6 @@ public:
         bool in_elapsed_chain = false;
         double chain_frac_days = 0.0;
 
-        std::string result;
-        result.reserve(sec.tokens.size() * 4);
-
         for (auto& tok : sec.tokens)
         {
             switch (tok.type)
@@ -1494,7 +1550,6 @@ public:
                 break;
             }
         }
-        return result;
     }
 
 private:
@@ -1504,9 +1559,9 @@ private:
     static void append_ampm(std::string& out, const std::string& pattern, bool pm) noexcept
     {
         if (pattern.size() == 5) // "AM/PM" or mixed case variants
-            out += pm ? pattern.substr(3, 2) : pattern.substr(0, 2);
+            out.append(pattern, pm ? 3 : 0, 2);
         else // "A/P" or mixed case variants
-            out += pm ? pattern.substr(2, 1) : pattern.substr(0, 1);
+            out.append(pattern, pm ? 2 : 0, 1);
     }
 
     // Append fractional seconds with leading zeros and rounding.
@@ -1547,14 +1602,14 @@ public:
     //      preserving surrounding literals, skips, and fills
     // =========================================================================
 
-    std::string format_fraction_section(const section& sec, const section_info& info, double raw_value, bool neg_section_owns_sign, int percent_count) const
+    void format_fraction_section(std::string& result, const section& sec, double raw_value, bool neg_section_owns_sign) const
     {
-        const fraction_layout& fl = info.frac_layout;
+        const fraction_layout& fl = sec.info.frac_layout;
 
         double scaled = raw_value / sec.scale;
         const bool negative = scaled < 0;
         if (negative) scaled = -scaled;
-        if (percent_count > 0) scaled *= std::pow(100.0, percent_count);
+        scaled *= sec.percent_scale;
 
         double int_part_d = std::floor(scaled);
         // Handle -0.0: std::floor(-0.0) returns -0.0, but we need 0.0
@@ -1563,7 +1618,7 @@ public:
         const double frac_part = scaled - int_part_d;
 
         // Determine best fraction: fixed denominator or best approximation
-        long long fixed_den = compute_fixed_denominator(sec, fl);
+        const long long fixed_den = sec.fixed_den;
         long long best_num, best_den;
         if (fixed_den > 0)
         {
@@ -1598,8 +1653,9 @@ public:
         char int_buf[320];
         auto r = std::to_chars(int_buf, int_buf + sizeof(int_buf), int_part_d, std::chars_format::fixed, 0);
         if (r.ec != std::errc())
-            return std::string(default_cell_width, '#');
-        std::string int_str = format_integer_str(std::string(int_buf, r.ptr), fl.int_counts);
+        { result.append(default_cell_width, '#'); return; }
+        std::string int_str;
+        append_integer_str(int_str, std::string_view(int_buf, static_cast<size_t>(r.ptr - int_buf)), fl.int_counts);
         bool int_suppressed = int_str.empty();
 
         // When the fraction part is zero, the integer must always be shown.
@@ -1657,8 +1713,6 @@ public:
         }
 
         // Walk tokens and assemble output
-        std::string result;
-        result.reserve(32);
         if (frac_effective_negative && !neg_section_owns_sign) result += '-';
 
         bool int_output = false, num_output = false, den_output = false;
@@ -1668,7 +1722,7 @@ public:
             const auto& tok = sec.tokens[i];
             const auto tt = tok.type;
 
-            if (tt == token_type::thousands) continue; // handled by format_integer_str
+            if (tt == token_type::thousands) continue; // handled by append_integer_str
             if (tt == token_type::percent) { result += '%'; continue; }
             if (tt == token_type::text_placeholder) { result += '@'; continue; }
             if (tt == token_type::scientific) {
@@ -1707,7 +1761,6 @@ public:
                 append_frac_placeholder(result, i, fl, int_str, num_str, den_str,
                                         no_fraction, int_output, num_output, den_output);
         }
-        return result;
     }
 
 private:
@@ -1870,28 +1923,17 @@ public:
     //   3. Format exponent with the specified number of digits
     // =========================================================================
 
-    std::string format_scientific_section(const section& sec, double raw_value, bool neg_section_owns_sign, int percent_count) const
+    void format_scientific_section(std::string& result, const section& sec, double raw_value, bool neg_section_owns_sign) const
     {
         double value = raw_value / sec.scale;
         const bool negative = value < 0;
         if (negative) value = -value;
-        if (percent_count > 0) value *= std::pow(100.0, percent_count);
+        value *= sec.percent_scale;
 
-        // Locate the scientific token (E+ or E-)
-        int sci_pos = -1;
-        token sci_tok;
-        for (size_t i = 0; i < sec.tokens.size(); ++i)
-        {
-            if (sec.tokens[i].type == token_type::scientific) { sci_tok = sec.tokens[i]; sci_pos = static_cast<int>(i); break; }
-        }
-
-        // Count digit placeholders up to the E token for precision
-        auto dc = count_digit_placeholders(sec, sci_pos);
-        // ECMA-376: "When a number format includes the comma as a thousands
-        // separator and also includes an exponent (E+, E-, e+, or e-
-        // designator), the format shall be treated as if a thousands separator
-        // were not present."
-        dc.thousands = 0;
+        // The scientific token (E+ or E-) and the digit placeholders before it
+        const int sci_pos = sec.sci_pos;
+        const token& sci_tok = sec.tokens[static_cast<size_t>(sci_pos)];
+        const digit_counts& dc = sec.digits;
         const int total_int = dc.total_int();
         const int total_frac = dc.total_frac();
 
@@ -1941,9 +1983,12 @@ public:
 
         // Format mantissa integer part
         const long long m_int = static_cast<long long>(std::floor(mantissa));
-        std::string m_int_str = format_integer_str(std::to_string(m_int), dc);
+        char m_int_buf[32];
+        auto m_int_r = std::to_chars(m_int_buf, m_int_buf + sizeof(m_int_buf), m_int);
+        std::string m_int_str;
+        append_integer_str(m_int_str, std::string_view(m_int_buf, static_cast<size_t>(m_int_r.ptr - m_int_buf)), dc);
 
-        // Format mantissa fractional part using format_decimal_str
+        // Format mantissa fractional part using append_decimal_str
         // to correctly handle mixed 0/#/? placeholders per ECMA-376.
         std::string m_frac_str;
         if (total_frac > 0)
@@ -1951,7 +1996,7 @@ public:
             const double m_frac = mantissa - m_int;
             // Epsilon added AFTER multiplication to avoid amplifying it by round_factor
             const long long fv = static_cast<long long>(std::round(m_frac * round_factor + float_epsilon));
-            m_frac_str = format_decimal_str(fv, total_frac, dc);
+            append_decimal_str(m_frac_str, fv, total_frac, dc);
         }
 
         // If no integer part was produced and there are no integer placeholders
@@ -2018,8 +2063,7 @@ public:
             exp_str += '0';
 
         // Walk tokens to build output, preserving surrounding text (literals, skips, fills)
-        std::string result;
-        result.reserve(m_int_str.size() + m_frac_str.size() + exp_str.size() + 16);
+        const size_t base = result.size();
         if (sci_effective_negative && !neg_section_owns_sign) result += '-';
 
         bool int_output = false, past_decimal = false;
@@ -2032,7 +2076,7 @@ public:
 
             if (append_common_token(result, tok)) continue;
             if (tt == token_type::percent)  { result += '%'; continue; }
-            if (tt == token_type::thousands)  continue; // handled by format_integer_str
+            if (tt == token_type::thousands)  continue; // handled by append_integer_str
             if (tt == token_type::text_placeholder) { result += '@'; continue; }
 
             if (tt == token_type::decimal && static_cast<int>(i) < sci_pos)
@@ -2069,11 +2113,10 @@ public:
         // E.g., "$".##E+00 with value 1.5 → "$1.5E+00", not "1$.5E+00".
         if (!int_output && !m_int_str.empty())
         {
-            const size_t dot = result.find('.');
-            const size_t ins = (dot != std::string::npos) ? dot : 0;
+            const size_t dot = result.find('.', base);
+            const size_t ins = (dot != std::string::npos) ? dot : base;
             result.insert(ins, m_int_str);
         }
-        return result;
     }
 
     // =========================================================================
@@ -2089,16 +2132,16 @@ public:
     //   4. Walk tokens and interpolate the formatted parts
     // =========================================================================
 
-    std::string format_regular_number_section(const section& sec, double raw_value, bool neg_section_owns_sign, int percent_count) const
+    void format_regular_number_section(std::string& result, const section& sec, double raw_value, bool neg_section_owns_sign) const
     {
         // Scale and handle sign
         double value = raw_value / sec.scale;
         const bool negative = value < 0;
         if (negative) value = -value;
-        if (percent_count > 0) value *= std::pow(100.0, percent_count);
+        value *= sec.percent_scale;
 
-        // Analyze digit placeholders
-        const auto dc = count_digit_placeholders(sec);
+        // Digit placeholders
+        const digit_counts& dc = sec.digits;
         const int total_frac = dc.total_frac();
 
         // Round to the specified precision.
@@ -2145,21 +2188,16 @@ public:
         char int_buf[320];
         auto int_r = std::to_chars(int_buf, int_buf + sizeof(int_buf), int_part_d, std::chars_format::fixed, 0);
         if (int_r.ec != std::errc())
-            return std::string(default_cell_width, '#');
-        const std::string int_str_raw(int_buf, int_r.ptr);
-
-        // Format integer and fraction strings
-        std::string int_str = format_integer_str(int_str_raw, dc);
-        std::string frac_str = format_decimal_str(frac_val, total_frac, dc);
+        { result.append(default_cell_width, '#'); return; }
+        const std::string_view int_str_raw(int_buf, static_cast<size_t>(int_r.ptr - int_buf));
+        const padded_digits padded(int_str_raw, dc.total_int());
 
-        // Pre-compute digit groups for each integer placeholder so that
-        // literals between placeholders (e.g., 0"#"0) are embedded
-        // between digit groups rather than appended after the integer part.
-        std::vector<std::string> int_digit_groups = compute_int_digit_groups(int_str_raw, dc);
+        // Format the fraction digits (one character per emitted placeholder)
+        std::string frac_str;
+        append_decimal_str(frac_str, frac_val, total_frac, dc);
 
         // Walk tokens and assemble output
-        std::string result;
-        result.reserve(int_str.size() + frac_str.size() + 16);
+        const size_t base = result.size();
         if (effective_negative && !neg_section_owns_sign) result += '-';
 
         bool past_decimal = false;
@@ -2190,13 +2228,13 @@ public:
             case token_type::digit_zero: case token_type::digit_hash: case token_type::digit_qmark:
                 if (!past_decimal)
                 {
-                    if (!int_digit_groups.empty())
+                    // Each integer placeholder emits its own digit group so that
+                    // literals between placeholders (e.g., 0"#"0) are embedded
+                    // between digit groups rather than appended after the integer part.
+                    if (dc.total_int() > 0)
                     {
-                        if (int_placeholder_index < static_cast<int>(int_digit_groups.size()))
-                        {
-                            result += int_digit_groups[int_placeholder_index];
-                            ++int_placeholder_index;
-                        }
+                        if (int_placeholder_index < dc.total_int())
+                            append_int_digit_group(result, padded, dc, int_placeholder_index++);
                         int_output = true;
                     }
                 }
@@ -2214,44 +2252,22 @@ public:
         // the right, regardless of literals embedded between digit placeholders.
         if (dc.thousands > 0)
         {
-            const size_t dot = result.find('.');
-            const size_t end = (dot != std::string::npos) ? dot : result.size();
-
-            int digit_count = 0;
-            for (size_t i = 0; i < end; ++i)
-                if (result[i] >= '0' && result[i] <= '9')
-                    ++digit_count;
-
-            if (digit_count > 3)
-            {
-                std::string with_commas;
-                with_commas.reserve(result.size() + (digit_count - 1) / 3);
-                int digits_seen = 0;
-                for (size_t i = 0; i < result.size(); ++i)
-                {
-                    if (i < end && result[i] >= '0' && result[i] <= '9')
-                    {
-                        if (digits_seen > 0 && (digit_count - digits_seen) % 3 == 0)
-                            with_commas += ',';
-                        ++digits_seen;
-                    }
-                    with_commas += result[i];
-                }
-                result = std::move(with_commas);
-            }
+            const size_t dot = result.find('.', base);
+            insert_thousands(result, base, (dot != std::string::npos) ? dot : result.size());
         }
 
         // ECMA-376: when there are no integer digit placeholders but the integer
         // part is non-zero, the integer part is still displayed.
-        if (!int_output && !int_str.empty() && int_part_d > 0)
+        if (!int_output && int_part_d > 0)
         {
+            std::string int_str;
+            append_integer_str(int_str, int_str_raw, dc);
             // Insert before the decimal point (or at start if no decimal point).
             // E.g., "$".# with value 1.5 → "$1.5", not "1$.5".
-            const size_t dot = result.find('.');
-            const size_t ins = (dot != std::string::npos) ? dot : 0;
+            const size_t dot = result.find('.', base);
+            const size_t ins = (dot != std::string::npos) ? dot : base;
             result.insert(ins, int_str);
         }
-        return result;
     }
 
 private:
@@ -2316,67 +2332,56 @@ private:
         return dc;
     }
 
-    // Pre-compute the digit group for each integer placeholder so that
+    // Integer digits left-padded with zeros to the number of integer
+    // placeholders, viewed in place instead of materializing the padded string.
+    struct padded_digits
+    {
+        std::string_view digits;
+        int pad = 0;
+        int first_nonzero = 0; // index of the first non-zero digit, or size() if all zeros
+
+        padded_digits(std::string_view raw, int total) noexcept
+            : digits(raw), pad(std::max(0, total - static_cast<int>(raw.size())))
+        {
+            const size_t nz = raw.find_first_not_of('0');
+            first_nonzero = (nz == std::string_view::npos) ? size() : pad + static_cast<int>(nz);
+        }
+
+        int size() const noexcept { return pad + static_cast<int>(digits.size()); }
+        char operator[](int i) const noexcept { return i < pad ? '0' : digits[static_cast<size_t>(i - pad)]; }
+    };
+
+    // Append the digit group for the index-th integer placeholder so that
     // literals between digit placeholders (e.g., 0"#"0) are correctly
     // embedded between digit groups instead of appended after the
-    // entire integer part.
-    static std::vector<std::string> compute_int_digit_groups(
-        const std::string& int_str_raw, const digit_counts& dc)
+    // entire integer part.  Extra digits (more digits than placeholders)
+    // go to the rightmost placeholder.
+    static void append_int_digit_group(std::string& out, const padded_digits& padded,
+                                       const digit_counts& dc, int index)
     {
         const int total = dc.total_int();
-        if (total <= 0) return {};
-
-        // Pad to the total number of integer placeholders
-        std::string padded = int_str_raw;
-        if (static_cast<int>(padded.size()) < total)
-            padded.insert(0, static_cast<size_t>(total - static_cast<int>(padded.size())), '0');
+        const int N = padded.size();
 
-        const int N = static_cast<int>(padded.size());
+        // Determine the range of padded characters for this placeholder.
+        const int start = index;
+        const int end = std::min(index == total - 1 ? N : index + 1, N);
+        if (start >= end) return;  // no digits for this placeholder
 
-        // Find first non-zero digit
-        int first_nonzero = -1;
-        for (size_t i = 0; i < padded.size(); ++i)
-            if (padded[i] != '0') { first_nonzero = static_cast<int>(i); break; }
-        if (first_nonzero < 0) first_nonzero = N;
+        const bool before = (start < padded.first_nonzero);
+        const char pat = (index < static_cast<int>(dc.int_pattern.size())) ? dc.int_pattern[index] : '0';
 
-        std::vector<std::string> groups(total);
-        for (int i = 0; i < total; ++i)
+        if (before)
         {
-            // Determine the range of padded characters for this placeholder.
-            // Extra digits (N > total) go to the rightmost placeholder.
-            int start, end;
-            if (i == total - 1)
-            {
-                start = total - 1;
-                end = N;  // rightmost gets remaining chars
-            }
-            else
-            {
-                start = i;
-                end = i + 1;
-            }
-            if (start < 0) start = 0;
-            if (end > N) end = N;
-            if (start >= end) continue;  // no digits for this placeholder
-
-            const bool before = (start < first_nonzero);
-            const char pat = (i < static_cast<int>(dc.int_pattern.size())) ? dc.int_pattern[i] : '0';
-
-            if (before)
-            {
-                if (pat == '#') continue;                     // suppressed
-                if (pat == '?') groups[i] = std::string(end - start, ' ');
-                else            groups[i] = std::string(end - start, '0');
-            }
-            else
-            {
-                groups[i] = padded.substr(start, end - start);
-            }
+            if (pat == '#') return;                       // suppressed
+            out.append(static_cast<size_t>(end - start), pat == '?' ? ' ' : '0');
+        }
+        else
+        {
+            for (int i = start; i < end; ++i) out += padded[i];
         }
-        return groups;
     }
 
-    // Format the integer part of a regular number.
+    // Append the integer part of a regular number.
     // Handles: leading zero padding (0 placeholders), leading zero suppression
     // (# placeholders), space padding (? placeholders), thousands separators,
     // and zero suppression.
@@ -2385,89 +2390,48 @@ private:
     // Before the first non-zero digit: '0'→'0', '#'→skip, '?'→' '.
     // At/after the first non-zero digit: output the actual digit.
     // This directly builds the correct output without fragile space-marking.
-    static std::string format_integer_str(const std::string& int_str_raw, const digit_counts& dc)
+    static void append_integer_str(std::string& out, std::string_view int_str_raw, const digit_counts& dc)
     {
         // Handle zero value with no mandatory zero placeholders.
         // ECMA-376: # suppresses insignificant zeros. If the integer part
         // has only # placeholders (no 0 or ?), zero should display as empty.
         // If there are ? placeholders, show spaces for alignment.
-        if (int_str_raw == "0")
+        if (int_str_raw == "0" && dc.int_zeros == 0)
         {
-            if (dc.int_zeros == 0)
-            {
-                if (dc.int_qmarks > 0)
-                    return std::string(dc.int_qmarks, ' ');
-                return {};
-            }
+            out.append(static_cast<size_t>(dc.int_qmarks), ' ');
+            return;
         }
 
-        const int total = dc.total_int();
-        std::string padded = int_str_raw;
-
-        // Pad to the total number of integer placeholders
-        if (static_cast<int>(padded.size()) < total)
-            padded.insert(0, static_cast<size_t>(total - static_cast<int>(padded.size())), '0');
-
-        // Find the first non-zero digit. If all zeros, treat all as "before".
-        int first_nonzero = -1;
-        for (size_t i = 0; i < padded.size(); ++i)
-            if (padded[i] != '0') { first_nonzero = static_cast<int>(i); break; }
-        if (first_nonzero < 0) first_nonzero = static_cast<int>(padded.size());
+        const padded_digits padded(int_str_raw, dc.total_int());
+        const size_t begin = out.size();
 
         // Build output directly from the pattern.
         // ECMA-376: # does not display extra zeros. It suppresses the zero
         // digit regardless of whether a 0 placeholder to its left has already
         // forced output (e.g., "0#" with value 0 → "0", not "00").
-        std::string result;
-        result.reserve(padded.size() + dc.thousands);
-        for (size_t i = 0; i < padded.size(); ++i)
+        for (int i = 0; i < padded.size(); ++i)
         {
-            const bool before = (static_cast<int>(i) < first_nonzero);
-            const char pat = (i < dc.int_pattern.size()) ? dc.int_pattern[i] : '0';
+            const bool before = (i < padded.first_nonzero);
+            const char pat = (i < static_cast<int>(dc.int_pattern.size())) ? dc.int_pattern[i] : '0';
 
             if (before)
             {
                 if (pat == '#') continue; // suppress
-                if (pat == '?') result += ' ';
-                else            result += '0';
+                out += (pat == '?') ? ' ' : '0';
             }
             else
             {
-                result += padded[i];
+                out += padded[i];
             }
         }
 
         // Insert thousands separators every 3 digits from the right.
-        // Only count actual digit characters (not spaces from ? padding).
+        // Only actual digit characters count (not spaces from ? padding).
         if (dc.thousands > 0)
-        {
-            int digit_count = 0;
-            for (char ch : result)
-                if (ch >= '0' && ch <= '9') ++digit_count;
-
-            if (digit_count > 3)
-            {
-                std::string with_commas;
-                with_commas.reserve(result.size() + (digit_count - 1) / 3);
-                int digits_seen = 0;
-                for (char ch : result)
-                {
-                    if (ch >= '0' && ch <= '9')
-                    {
-                        // Insert comma every 3 digits counting from right
-                        if (digits_seen > 0 && (digit_count - digits_seen) % 3 == 0)
-                            with_commas += ',';
-                        ++digits_seen;
-                    }
-                    with_commas += ch;
-                }
-                result = std::move(with_commas);
-            }
-        }
-        return result;
+            insert_thousands(out, begin, out.size());
     }
 
-    // Format the decimal part of a regular number.
+    // Append the decimal part of a regular number.
     // Uses frac_pattern to correctly distinguish 0/#/? positions:
     //   0 → always show digit (even if zero)
     //   # → show digit, suppress trailing zeros entirely
@@ -2476,45 +2440,42 @@ private:
     // Trailing suppression: positions beyond the rightmost "must-keep"
     // position are dropped.  A position must be kept if its placeholder is
     // '0' or '?', or if its digit is non-zero.
-    static std::string format_decimal_str(long long frac_val, int total_frac, const digit_counts& dc)
+    static void append_decimal_str(std::string& out, long long frac_val, int total_frac, const digit_counts& dc)
     {
-        if (total_frac <= 0) return {};
+        if (total_frac <= 0) return;
 
-        // Convert to zero-padded string of length total_frac
-        std::string s = std::to_string(frac_val);
-        if (static_cast<int>(s.size()) < total_frac)
-            s.insert(0, static_cast<size_t>(total_frac - static_cast<int>(s.size())), '0');
+        // View as a zero-padded digit string of length total_frac
+        char buf[32];
+        auto r = std::to_chars(buf, buf + sizeof(buf), frac_val);
+        const padded_digits s(std::string_view(buf, static_cast<size_t>(r.ptr - buf)), total_frac);
 
         // Find the rightmost position that must be kept.
         // '0' and '?' placeholders always keep their position (the latter
         // shows a space for zero).  Non-zero digits always keep their position.
         int last_keep = -1;
-        for (int i = static_cast<int>(s.size()) - 1; i >= 0; --i)
+        for (int i = s.size() - 1; i >= 0; --i)
         {
             const char pat = (i < static_cast<int>(dc.frac_pattern.size()))
                 ? dc.frac_pattern[i] : '0';
             if (pat == '0' || pat == '?' || s[i] != '0') { last_keep = i; break; }
         }
-        if (last_keep < 0) return {};
+        if (last_keep < 0) return;
 
         // Build output with per-position placeholder rules
-        std::string result;
-        result.reserve(static_cast<size_t>(last_keep) + 1);
         for (int i = 0; i <= last_keep; ++i)
         {
             const char pat = (i < static_cast<int>(dc.frac_pattern.size()))
                 ? dc.frac_pattern[i] : '0';
             if (s[i] != '0')
-                result += s[i];           // non-zero digit → always show
+                out += s[i];           // non-zero digit → always show
             else if (pat == '?')
-                result += ' ';            // ? placeholder → space for zero
+                out += ' ';            // ? placeholder → space for zero
             else
-                result += '0';            // '0' or '#' placeholder → show zero
+                out += '0';            // '0' or '#' placeholder → show zero
             // '#' with zero digit before last_keep is not a trailing zero
             // (it is followed by a mandatory '0' or '?' placeholder), so
             // it is correctly shown as '0' above.
         }
-        return result;
     }
 };
 
@@ -2539,7 +2500,30 @@ number_format& number_format::operator=(number_format&&) noexcept = default;
 
 std::string number_format::format(double number, bool date1904) const
 {
-    return _impl->format_double(number, date1904);
+    std::string result;
+    _impl->format_double(result, number, date1904);
+    return result;
+}
+
+void number_format::format_to(std::string& out, double number, bool date1904) const
+{
+    _impl->format_double(out, number, date1904);
+}
+
+std::size_t number_format::format_to(char* buf, std::size_t cap, double number, bool date1904) const
+{
+    // Per-thread scratch buffer: its capacity is kept between calls, so
+    // steady-state formatting into a caller buffer does not allocate.
+    thread_local std::string scratch;
+    scratch.clear();
+    _impl->format_double(scratch, number, date1904);
+    if (cap > 0)
+    {
+        const std::size_t n = std::min(scratch.size(), cap - 1);
+        std::memcpy(buf, scratch.data(), n);
+        buf[n] = '\0';
+    }
+    return scratch.size();
 }
 
 std::string number_format::format(const std::string& text) const
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <string>
 
@@ -22,6 +23,16 @@ public:
     std::string format(double number, bool date1904 = false) const;
     std::string format(const std::string& text) const;
 
+    /**
+     * Append the formatted number to out, reusing its capacity.
+     */
+    void format_to(std::string& out, double number, bool date1904 = false) const;
+    /**
+     * Write the formatted number to buf, truncated to cap - 1 characters and NUL-terminated when cap > 0.
+     * Returns the full length of the formatted text; a result >= cap means the output was truncated.
+     */
+    std::size_t format_to(char* buf, std::size_t cap, double number, bool date1904 = false) const;
+
 private:
     struct impl;
     std::unique_ptr<impl> _impl;
@@ -5,84 +5,1452 @@
 #include "number_format.hpp"
 
 #include <cstring>
+#include <cctype>
+#include <charconv>
+#include <algorithm>
 #include <string>
+#include <string_view>
+#include <stdexcept>
 #include <vector>
+#include <deque>
 #include <map>
+#include <unordered_map>
+#include <tuple>
+#include <type_traits>
 #include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <cstdint>
+#include <limits>
 #include <cmath>
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#define XLSXTEXT_NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#define XLSXTEXT_WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#ifdef XLSXTEXT_NOMINMAX
+#undef NOMINMAX
+#undef XLSXTEXT_NOMINMAX
+#endif
+#ifdef XLSXTEXT_WIN32_LEAN_AND_MEAN
+#undef WIN32_LEAN_AND_MEAN
+#undef XLSXTEXT_WIN32_LEAN_AND_MEAN
+#endif
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace xlsxtext
 {
 
-    class reference
+    class reference
+    {
+    private:
+        /**
+         * Letters of the columns A to XFD, 4 bytes each: up to 3 letters and their count.
+         */
+        static const char *column_names() noexcept
+        {
+            static const auto names = []
+            {
+                std::unique_ptr<char[]> names(new char[(max_col + 1) * 4]());
+                for (unsigned col = 1; col <= max_col; ++col)
+                    names[col * 4 + 3] = static_cast<char>(write_column(col, &names[col * 4]));
+                return names;
+            }();
+            return names.get();
+        }
+        static size_t write_column(unsigned col, char *out) noexcept
+        {
+            char letters[8];
+            size_t size = 0;
+            for (; col > 0; col = (col - 1) / 26)
+                letters[size++] = static_cast<char>('A' + (col - 1) % 26);
+            for (size_t i = 0; i < size; ++i)
+                out[i] = letters[size - 1 - i];
+            return size;
+        }
+
+    public:
+        static constexpr unsigned max_col = 16384; // XFD
+        static constexpr size_t max_size = 17;     // letters of the largest unsigned column and digits of the largest row
+
+        unsigned row;
+        unsigned col;
+
+        reference() noexcept : reference(0, 0) {}
+        reference(unsigned row, unsigned col) noexcept : row(row), col(col) {}
+        reference(const std::string &value) noexcept { this->value(std::string_view(value)); }
+        reference(std::string_view value) noexcept { this->value(value); }
+        reference(const char *value) noexcept { this->value(std::string_view(value)); }
+
+        /**
+         * Parse "B17": the letters then the digits, an invalid reference (0, 0) for anything else, a missing part or
+         * a row or column past the largest unsigned.
+         */
+        void value(std::string_view value) noexcept
+        {
+            constexpr unsigned most = std::numeric_limits<unsigned>::max();
+            row = col = 0;
+            size_t i = 0, size = value.size();
+            for (unsigned letter; i < size && (letter = static_cast<unsigned char>(value[i] - 'A')) < 26 && col <= (most - letter - 1) / 26; ++i)
+                col = col * 26 + letter + 1;
+            for (unsigned digit; i < size && (digit = static_cast<unsigned char>(value[i] - '0')) < 10 && row <= (most - digit) / 10; ++i)
+                row = row * 10 + digit;
+            if (i < size || row == 0 || col == 0)
+                row = col = 0;
+        }
+        /**
+         * Write "B17" to out (at least max_size bytes, not terminated) without allocating, returning its length;
+         * 0 for an invalid reference.
+         */
+        size_t to_chars(char *out) const noexcept
+        {
+            if (row == 0 || col == 0)
+                return 0;
+            auto size = static_cast<size_t>(col <= max_col ? column_name(col, out) : write_column(col, out));
+            return std::to_chars(out + size, out + max_size, row).ptr - out;
+        }
+        std::string value() const noexcept
+        {
+            char buffer[max_size];
+            return std::string(buffer, to_chars(buffer));
+        }
+
+        /**
+         * Letters of a column from a table for A to XFD, an empty view beyond.
+         */
+        static std::string_view column_name(unsigned col) noexcept
+        {
+            if (col == 0 || col > max_col)
+                return {};
+            auto name = column_names() + col * 4;
+            return std::string_view(name, static_cast<size_t>(name[3]));
+        }
+
+        operator bool() const noexcept { return row > 0 && col > 0; }
+
+    private:
+        static size_t column_name(unsigned col, char *out) noexcept
+        {
+            auto name = column_name(col);
+            std::memcpy(out, name.data(), name.size());
+            return name.size();
+        }
+    };
+
+    class cell
+    {
+    public:
+        reference refer;
+        std::string value;
+        cell(reference reference, std::string value = "") noexcept : refer(reference), value(value) {}
+        cell(std::string reference, std::string value = "") noexcept : refer(reference), value(value) {}
+        cell(unsigned row, unsigned col, std::string value = "") noexcept : refer(row, col), value(value) {}
+    };
+
+    class workbook;
+
+    /**
+     * A cell as stored in the sheet: its type and raw value, formatted to display text only when text() is called.
+     */
+    class raw_cell
+    {
+    public:
+        enum value_type
+        {
+            type_empty,         // no value
+            type_number,        // number
+            type_boolean,       // boolean, number is 0 or 1
+            type_shared_string, // index into the shared string table
+            type_string,        // inline or formula string, or a value that is not a number
+            type_error,         // error code such as #N/A, in raw
+            type_date,          // ISO 8601 date, in raw
+        };
+
+        reference refer;
+        value_type type = type_empty;
+        double number = 0;    // type_number and type_boolean
+        unsigned index = 0;   // type_shared_string
+        std::string raw;      // value as stored in the sheet
+        bool formula = false; // the value is the cached result of a formula, text() returns it as stored
+
+        /**
+         * Display text, the same as cell::value of a worksheet read as text.
+         */
+        std::string text() const;
+        /**
+         * String value without a copy: the shared string table entry for type_shared_string, otherwise raw.
+         */
+        std::string_view string() const;
+
+    private:
+        const workbook *_workbook = nullptr;
+        long _xf = -1; // cellXfs entry formatting the value, -1 for none
+
+        friend class workbook;
+    };
+
+    /**
+     * Non-owning view of one row handed out by worksheet::for_each_row and for_each_raw_row, only valid during the callback.
+     */
+    template <typename Cell>
+    class basic_row_view
+    {
+    private:
+        unsigned _index;
+        const Cell *_cells;
+        size_t _size;
+
+    public:
+        basic_row_view(unsigned index, const Cell *cells, size_t size) noexcept : _index(index), _cells(cells), _size(size) {}
+
+        unsigned index() const noexcept { return _index; }
+        size_t size() const noexcept { return _size; }
+        bool empty() const noexcept { return _size == 0; }
+        const Cell &operator[](size_t i) const noexcept { return _cells[i]; }
+        const Cell *begin() const noexcept { return _cells; }
+        const Cell *end() const noexcept { return _cells + _size; }
+    };
+    using row_view = basic_row_view<cell>;
+    using raw_row_view = basic_row_view<raw_cell>;
+
+    class worksheet;
+
+    /**
+     * A cell of a read worksheet, built on the fly from packed_rows: its text is a view into the worksheet.
+     */
+    class packed_cell
+    {
+    public:
+        reference refer;
+        std::string_view value;
+    };
+
+    /**
+     * The rows of a read worksheet, packed into a few arrays instead of one vector and one string per cell:
+     * one entry per row, the column and text end of every cell and all text back to back in one arena, about
+     * 8 bytes per cell plus its text.
+     *
+     * Rows and cells are handed out as lightweight views built when they are dereferenced (row iterators and cell
+     * iterators keep the current view, so `for (auto &cell : row)` works); views are valid until the worksheet is
+     * read again or destroyed.
+     */
+    class packed_rows
+    {
+    private:
+        struct row_entry
+        {
+            unsigned index; // row number
+            size_t first;   // first cell in _cols and _ends
+            size_t text;    // offset of the row text in _text
+        };
+        std::vector<row_entry> _rows{};
+        std::vector<unsigned> _cols{};
+        std::vector<std::uint32_t> _ends{}; // end of the cell text, relative to the text of its row
+        std::string _text{};
+        bool _ordered = true; // rows and the cells of every row in ascending order, as the format requires
+        std::vector<std::uint32_t> _lookup{}; // position + 1 of every row number from the first one, 0 for none
+
+        void clear() noexcept
+        {
+            _rows.clear();
+            _cols.clear();
+            _ends.clear();
+            _text.clear();
+            _ordered = true;
+            _lookup.clear();
+        }
+        void push_row(unsigned index)
+        {
+            _ordered = _ordered && (_rows.empty() || _rows.back().index <= index);
+            _rows.push_back({index, _cols.size(), _text.size()});
+        }
+        void push_cell(unsigned col, std::string_view value)
+        {
+            _ordered = _ordered && (_cols.size() == _rows.back().first || _cols.back() <= col);
+            _cols.push_back(col);
+            _text += value;
+            _ends.push_back(static_cast<std::uint32_t>(_text.size() - _rows.back().text));
+        }
+        template <typename Cells>
+        void push_back(unsigned index, const Cells &cells)
+        {
+            push_row(index);
+            for (auto &cell : cells)
+                push_cell(cell.refer.col, cell.value);
+        }
+        void reserve(size_t rows, size_t cells, size_t text)
+        {
+            _rows.reserve(rows);
+            _cols.reserve(cells);
+            _ends.reserve(cells);
+            _text.reserve(text);
+        }
+        void append(const packed_rows &other)
+        {
+            _ordered = _ordered && other._ordered && (_rows.empty() || other._rows.empty() || _rows.back().index <= other._rows.front().index);
+            auto first = _cols.size(), text = _text.size();
+            for (auto row : other._rows)
+                _rows.push_back({row.index, row.first + first, row.text + text});
+            _cols.insert(_cols.end(), other._cols.begin(), other._cols.end());
+            _ends.insert(_ends.end(), other._ends.begin(), other._ends.end());
+            _text += other._text;
+        }
+        void shrink_to_fit()
+        {
+            _rows.shrink_to_fit();
+            _cols.shrink_to_fit();
+            _ends.shrink_to_fit();
+            _text.shrink_to_fit();
+        }
+        /**
+         * Build the row number table of find_row once the rows are complete, unless the row numbers are so sparse
+         * that it would outweigh the rows themselves (a binary search is used then).
+         */
+        void index_rows()
+        {
+            _lookup.clear();
+            if (!_ordered || _rows.empty() || _rows.size() >= std::numeric_limits<std::uint32_t>::max())
+                return;
+            size_t span = _rows.back().index - _rows.front().index + 1;
+            if (span > _rows.size() * 2 + 64)
+                return;
+            _lookup.assign(span, 0);
+            for (size_t i = _rows.size(); i-- > 0;)
+                _lookup[_rows[i].index - _rows.front().index] = static_cast<std::uint32_t>(i + 1);
+            _lookup.shrink_to_fit();
+        }
+
+        friend class worksheet;
+
+    public:
+        class row
+        {
+        private:
+            const packed_rows *_table = nullptr;
+            size_t _row = 0;
+
+        public:
+            class const_iterator
+            {
+            private:
+                const packed_rows *_table = nullptr;
+                size_t _row = 0;
+                size_t _cell = 0;
+                mutable packed_cell _current{};
+
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = packed_cell;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const packed_cell *;
+                using reference = const packed_cell &;
+
+                const_iterator() noexcept {}
+                const_iterator(const packed_rows *table, size_t row, size_t cell) noexcept : _table(table), _row(row), _cell(cell) {}
+
+                const packed_cell &operator*() const noexcept { return _current = _table->cell_at(_row, _cell); }
+                const packed_cell *operator->() const noexcept { return &**this; }
+                const_iterator &operator++() noexcept
+                {
+                    ++_cell;
+                    return *this;
+                }
+                const_iterator operator++(int) noexcept
+                {
+                    auto it = *this;
+                    ++_cell;
+                    return it;
+                }
+                bool operator==(const const_iterator &other) const noexcept { return _cell == other._cell; }
+                bool operator!=(const const_iterator &other) const noexcept { return _cell != other._cell; }
+            };
+
+            row() noexcept {}
+            row(const packed_rows *table, size_t row) noexcept : _table(table), _row(row) {}
+
+            unsigned index() const noexcept { return _table->_rows[_row].index; }
+            size_t size() const noexcept { return _table->row_end(_row) - _table->_rows[_row].first; }
+            bool empty() const noexcept { return size() == 0; }
+            packed_cell operator[](size_t i) const noexcept { return _table->cell_at(_row, _table->_rows[_row].first + i); }
+            const_iterator begin() const noexcept { return const_iterator(_table, _row, _table->_rows[_row].first); }
+            const_iterator end() const noexcept { return const_iterator(_table, _row, _table->row_end(_row)); }
+        };
+
+        class const_iterator
+        {
+        private:
+            const packed_rows *_table = nullptr;
+            size_t _row = 0;
+            mutable packed_rows::row _current{};
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = packed_rows::row;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const packed_rows::row *;
+            using reference = const packed_rows::row &;
+
+            const_iterator() noexcept {}
+            const_iterator(const packed_rows *table, size_t row) noexcept : _table(table), _row(row) {}
+
+            const packed_rows::row &operator*() const noexcept { return _current = packed_rows::row(_table, _row); }
+            const packed_rows::row *operator->() const noexcept { return &**this; }
+            const_iterator &operator++() noexcept
+            {
+                ++_row;
+                return *this;
+            }
+            const_iterator operator++(int) noexcept
+            {
+                auto it = *this;
+                ++_row;
+                return it;
+            }
+            bool operator==(const const_iterator &other) const noexcept { return _row == other._row; }
+            bool operator!=(const const_iterator &other) const noexcept { return _row != other._row; }
+        };
+
+        size_t size() const noexcept { return _rows.size(); }
+        bool empty() const noexcept { return _rows.empty(); }
+        /**
+         * Number of cells in all rows.
+         */
+        size_t cell_count() const noexcept { return _cols.size(); }
+        row operator[](size_t i) const noexcept { return row(this, i); }
+        const_iterator begin() const noexcept { return const_iterator(this, 0); }
+        const_iterator end() const noexcept { return const_iterator(this, _rows.size()); }
+
+        static constexpr size_t npos = static_cast<size_t>(-1);
+        /**
+         * Position of the row numbered index, npos if there is none. A table lookup for rows read by a worksheet,
+         * else a binary search, or a linear one for the broken files storing rows or cells out of order.
+         */
+        size_t find_row(unsigned index) const noexcept
+        {
+            if (!_lookup.empty())
+            {
+                auto i = static_cast<size_t>(index) - _rows.front().index;
+                return index >= _rows.front().index && i < _lookup.size() && _lookup[i] ? _lookup[i] - 1 : npos;
+            }
+            auto it = _ordered ? std::lower_bound(_rows.begin(), _rows.end(), index, [](const row_entry &row, unsigned index)
+                                                  { return row.index < index; })
+                               : std::find_if(_rows.begin(), _rows.end(), [index](const row_entry &row)
+                                              { return row.index == index; });
+            return it != _rows.end() && it->index == index ? static_cast<size_t>(it - _rows.begin()) : npos;
+        }
+        /**
+         * The cell of a row (from find_row) in column col, false if there is none.
+         */
+        bool find_cell(size_t row, unsigned col, packed_cell &cell) const noexcept
+        {
+            auto begin = _cols.begin() + _rows[row].first, end = _cols.begin() + row_end(row);
+            auto it = _ordered ? std::lower_bound(begin, end, col) : std::find(begin, end, col);
+            if (it == end || *it != col)
+                return false;
+            cell = cell_at(row, it - _cols.begin());
+            return true;
+        }
+
+    private:
+        size_t row_end(size_t row) const noexcept { return row + 1 < _rows.size() ? _rows[row + 1].first : _cols.size(); }
+        packed_cell cell_at(size_t row, size_t cell) const noexcept
+        {
+            auto &entry = _rows[row];
+            auto begin = cell == entry.first ? 0 : _ends[cell - 1];
+            return {reference(entry.index, _cols[cell]), std::string_view(_text.data() + entry.text + begin, _ends[cell] - begin)};
+        }
+    };
+
+    /**
+     * Projection of a worksheet read: the columns to keep, by letters ("A", "BC") or 1-based index.
+     * Cells of other columns are skipped as soon as their reference is known, their value is neither decoded nor formatted.
+     * An empty set keeps every column; a set given only invalid columns (0, past XFD, not upper case letters) keeps none.
+     */
+    class columns
+    {
+    private:
+        std::vector<std::uint64_t> _bits{};
+        bool _selected = false;
+
+    public:
+        columns() noexcept {}
+        columns(std::initializer_list<unsigned> cols)
+        {
+            for (auto col : cols)
+                add(col);
+        }
+        columns(std::initializer_list<std::string> cols)
+        {
+            for (auto &col : cols)
+                add(col);
+        }
+
+        columns &add(unsigned col)
+        {
+            _selected = true;
+            if (col == 0 || col > reference::max_col)
+                return *this;
+            if (_bits.size() <= col / 64)
+                _bits.resize(col / 64 + 1);
+            _bits[col / 64] |= std::uint64_t(1) << (col % 64);
+            return *this;
+        }
+        columns &add(const std::string &letters)
+        {
+            unsigned col = 0;
+            for (auto c : letters)
+            {
+                if (c < 'A' || 'Z' < c || col > reference::max_col)
+                    return add(0u);
+                col = col * 26 + (c - 'A') + 1;
+            }
+            return add(col);
+        }
+
+        bool empty() const noexcept { return !_selected; }
+        bool contains(unsigned col) const noexcept { return !_selected || (col / 64 < _bits.size() && (_bits[col / 64] >> (col % 64) & 1)); }
+    };
+
+    /**
+     * Rows of a worksheet read: rows first to last (1-based, inclusive), at most limit non-empty rows of them.
+     * Rows before first are skipped unparsed, and reading stops as soon as the range is exhausted: the rest of the part,
+     * merge cells included, is neither inflated nor parsed.
+     */
+    class row_range
+    {
+    public:
+        unsigned first = 1;
+        unsigned last = std::numeric_limits<unsigned>::max();
+        size_t limit = std::numeric_limits<size_t>::max();
+
+        row_range() noexcept {}
+
+        /**
+         * Rows first to last, at most limit of them. A named factory rather than a constructor, so that a number or a
+         * braced pair never turns into a range: read(5) reads with 5 threads and read({1, 3}) the columns A and C.
+         */
+        static row_range rows(unsigned first, unsigned last = std::numeric_limits<unsigned>::max(), size_t limit = std::numeric_limits<size_t>::max()) noexcept
+        {
+            row_range range;
+            range.first = first;
+            range.last = last;
+            range.limit = limit;
+            return range;
+        }
+        /**
+         * The first limit non-empty rows, e.g. for a preview.
+         */
+        static row_range head(size_t limit) noexcept { return rows(1, std::numeric_limits<unsigned>::max(), limit); }
+    };
+
+    /**
+     * Opt-in counters of where reading a workbook goes, filled while attached with workbook::collect_statistics.
+     *
+     * Counters are relaxed atomics, so one object can be shared by parallel reads and looked at while they run; times
+     * of parallel work are summed. A worksheet read keeps its counters locally and adds them once at its end, so leaving
+     * statistics on costs a few clock reads per part chunk and per sampled cell.
+     */
+    class statistics
+    {
+    public:
+        enum phase_type
+        {
+            phase_open,           // opening the archive and indexing its entries
+            phase_inflate,        // decompressing parts
+            phase_relationships,  // parsing the package and workbook relationships
+            phase_shared_strings, // building the shared string table (scanning it when lazy)
+            phase_styles,         // parsing styles and compiling number formats
+            phase_workbook,       // parsing the workbook part
+            phase_parse,          // parsing worksheets, for_each_row callbacks included
+            phase_format,         // formatting cell values to text, estimated from every 16th cell
+            phase_count,
+        };
+        enum cell_type // by the t attribute of the cell
+        {
+            cell_number,        // n or none
+            cell_shared_string, // s
+            cell_boolean,       // b
+            cell_error,         // e
+            cell_string,        // str
+            cell_inline_string, // inlineStr
+            cell_date,          // d
+            cell_type_count,
+        };
+        struct part
+        {
+            std::uint64_t compressed = 0;   // compressed bytes read from the archive
+            std::uint64_t uncompressed = 0; // bytes inflated
+            std::uint64_t reads = 0;
+        };
+
+        std::atomic<std::uint64_t> nanoseconds[phase_count]{};
+        std::atomic<std::uint64_t> cells[cell_type_count]{};
+        std::atomic<std::uint64_t> rows{0};
+        std::atomic<std::uint64_t> format_hits{0};          // values formatted with the format compiled when styles were read
+        std::atomic<std::uint64_t> format_misses{0};        // values whose format code failed to compile and was parsed again
+        std::atomic<std::uint64_t> shared_string_hits{0};   // lazy shared strings that were already decoded
+        std::atomic<std::uint64_t> shared_string_misses{0}; // lazy shared strings decoded on first use
+        std::atomic<std::uint64_t> allocations{0};          // inflated part buffers, cell storage and cell strings too long for the small-string buffer
+
+        statistics() noexcept {}
+        statistics(const statistics &) = delete;
+        statistics &operator=(const statistics &) = delete;
+
+        static const char *phase_name(phase_type phase) noexcept
+        {
+            static const char *names[phase_count] = {"open", "inflate", "relationships", "shared strings", "styles", "workbook", "parse", "format"};
+            return phase < phase_count ? names[phase] : "";
+        }
+
+        /**
+         * Bytes read per part name, summed over every read of the part.
+         */
+        std::map<std::string, part> parts() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _parts;
+        }
+
+        void reset() noexcept
+        {
+            for (auto &value : nanoseconds)
+                value = 0;
+            for (auto &value : cells)
+                value = 0;
+            rows = format_hits = format_misses = shared_string_hits = shared_string_misses = allocations = 0;
+            std::lock_guard<std::mutex> lock(_mutex);
+            _parts.clear();
+        }
+
+        void add(std::atomic<std::uint64_t> &counter, std::uint64_t value) noexcept { counter.fetch_add(value, std::memory_order_relaxed); }
+        void add_time(phase_type phase, std::uint64_t ns) noexcept { add(nanoseconds[phase], ns); }
+        void add_part(const std::string &name, std::uint64_t compressed, std::uint64_t uncompressed)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto &part = _parts[name];
+            part.compressed += compressed;
+            part.uncompressed += uncompressed;
+            ++part.reads;
+        }
+
+        static std::uint64_t now() noexcept
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        /**
+         * Adds the time from construction to stop() (or destruction) to a phase; does nothing without statistics.
+         */
+        class timer
+        {
+        private:
+            statistics *_statistics;
+            phase_type _phase;
+            std::uint64_t _start;
+
+        public:
+            timer(statistics *stats, phase_type phase) noexcept : _statistics(stats), _phase(phase), _start(stats ? now() : 0) {}
+            ~timer() { stop(); }
+            timer(const timer &) = delete;
+            timer &operator=(const timer &) = delete;
+
+            void stop() noexcept
+            {
+                if (_statistics)
+                    _statistics->add_time(_phase, now() - _start);
+                _statistics = nullptr;
+            }
+        };
+
+    private:
+        mutable std::mutex _mutex;
+        std::map<std::string, part> _parts{};
+    };
+
+    /**
+     * Minimal forward-only XML tokenizer over a contiguous buffer.
+     *
+     * Only what the package parts need is recognised: elements, end elements, character data and CDATA.
+     * Declarations, processing instructions, comments and DOCTYPE are skipped. Entity references are left
+     * encoded until the caller asks for the decoded text (same escapes and end-of-line handling as pugixml's parse_default).
+     *
+     * When the buffer is not the final piece of the document, markup cut at the end of the buffer is reported as
+     * node_end without being consumed, so the caller can retry from position() once more data is available.
+     */
+    class xml_reader
+    {
+    public:
+        enum node_type
+        {
+            node_end,         // end of buffer
+            node_malformed,   // truncated or broken markup
+            node_element,     // <name ...> or <name .../>
+            node_end_element, // </name>
+            node_text,        // character data or CDATA section
+        };
+
+    private:
+        const char *_cur;
+        const char *_end;
+        bool _final;
+        bool _malformed = false;
+
+        std::string_view _name{};
+        std::string_view _attributes{};
+        std::string_view _text{};
+        bool _empty = false;
+        bool _cdata = false;
+
+        static bool is_space(char c) noexcept { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+        const char *find(const char *pattern, size_t size) const noexcept
+        {
+            for (auto p = _cur; static_cast<size_t>(_end - p) >= size; ++p)
+            {
+                p = static_cast<const char *>(std::memchr(p, pattern[0], _end - p));
+                if (p == nullptr || static_cast<size_t>(_end - p) < size)
+                    break;
+                if (std::memcmp(p, pattern, size) == 0)
+                    return p;
+            }
+            return nullptr;
+        }
+
+        node_type truncated() noexcept
+        {
+            if (!_final)
+                return node_end;
+            _malformed = true;
+            return node_malformed;
+        }
+
+    public:
+        xml_reader(const char *begin, const char *end, bool final = true) noexcept : _cur(begin), _end(end), _final(final) {}
+
+        const char *position() const noexcept { return _cur; }
+        bool malformed() const noexcept { return _malformed; }
+        std::string_view name() const noexcept { return _name; }
+        bool empty_element() const noexcept { return _empty; }
+
+        node_type next() noexcept
+        {
+            while (_cur < _end)
+            {
+                if (*_cur != '<')
+                {
+                    auto p = static_cast<const char *>(std::memchr(_cur, '<', _end - _cur));
+                    if (p == nullptr)
+                        p = _end;
+                    _text = std::string_view(_cur, p - _cur);
+                    _cdata = false;
+                    _cur = p;
+                    return node_text;
+                }
+
+                auto rest = static_cast<size_t>(_end - _cur);
+                if (rest >= 2 && _cur[1] == '?')
+                {
+                    auto p = find("?>", 2);
+                    if (p == nullptr)
+                        return truncated();
+                    _cur = p + 2;
+                }
+                else if (rest >= 4 && std::memcmp(_cur, "<!--", 4) == 0)
+                {
+                    auto p = find("-->", 3);
+                    if (p == nullptr)
+                        return truncated();
+                    _cur = p + 3;
+                }
+                else if (rest >= 9 && std::memcmp(_cur, "<![CDATA[", 9) == 0)
+                {
+                    auto p = find("]]>", 3);
+                    if (p == nullptr)
+                        return truncated();
+                    _text = std::string_view(_cur + 9, p - _cur - 9);
+                    _cdata = true;
+                    _cur = p + 3;
+                    return node_text;
+                }
+                else if (rest >= 2 && _cur[1] == '!')
+                {
+                    auto p = static_cast<const char *>(std::memchr(_cur, '>', rest));
+                    if (p == nullptr || (!_final && rest < 9))
+                        return truncated();
+                    _cur = p + 1;
+                }
+                else
+                {
+                    bool end_element = rest >= 2 && _cur[1] == '/';
+                    auto name = _cur + (end_element ? 2 : 1), p = name;
+                    while (p < _end && !is_space(*p) && *p != '/' && *p != '>')
+                        ++p;
+                    if (p == _end)
+                        return truncated();
+                    if (p == name)
+                    {
+                        _malformed = true;
+                        return node_malformed;
+                    }
+                    _name = std::string_view(name, p - name);
+
+                    auto attributes = p;
+                    char quote = 0;
+                    for (; p < _end; ++p)
+                    {
+                        if (quote)
+                        {
+                            if (*p == quote)
+                                quote = 0;
+                        }
+                        else if (*p == '"' || *p == '\'')
+                            quote = *p;
+                        else if (*p == '>')
+                            break;
+                    }
+                    if (p == _end)
+                        return truncated();
+
+                    _empty = !end_element && p[-1] == '/';
+                    _attributes = std::string_view(attributes, p - attributes - (_empty ? 1 : 0));
+                    _cur = p + 1;
+                    return end_element ? node_end_element : node_element;
+                }
+            }
+            return node_end;
+        }
+
+        /**
+         * Raw (still escaped) value of an attribute of the current element, empty when absent.
+         */
+        std::string_view attribute(std::string_view name) const noexcept
+        {
+            auto p = _attributes.data(), end = p + _attributes.size();
+            while (p < end)
+            {
+                while (p < end && is_space(*p))
+                    ++p;
+                auto key = p;
+                while (p < end && *p != '=' && !is_space(*p))
+                    ++p;
+                auto key_size = static_cast<size_t>(p - key);
+                while (p < end && *p != '"' && *p != '\'')
+                    ++p;
+                if (p == end)
+                    break;
+                auto quote = *p++;
+                auto value = p;
+                while (p < end && *p != quote)
+                    ++p;
+                if (key_size == name.size() && std::memcmp(key, name.data(), key_size) == 0)
+                    return std::string_view(value, p - value);
+                ++p;
+            }
+            return {};
+        }
+
+        /**
+         * Append the decoded current text node.
+         */
+        void text(std::string &out) const
+        {
+            if (_cdata)
+                out.append(_text.data(), _text.size());
+            else
+                decode(_text, out);
+        }
+
+        /**
+         * Skip the rest of the current element including all its descendants.
+         */
+        bool skip() noexcept
+        {
+            if (_empty)
+                return true;
+            for (unsigned depth = 1;;)
+            {
+                switch (next())
+                {
+                case node_element:
+                    if (!_empty)
+                        ++depth;
+                    break;
+                case node_end_element:
+                    if (--depth == 0)
+                        return true;
+                    break;
+                case node_text:
+                    break;
+                default:
+                    return false;
+                }
+            }
+        }
+
+        /**
+         * Append the decoded text of the current element and move past its end, matching pugixml's text() under
+         * parse_default: the first CDATA section or character data that is not only whitespace directly inside
+         * the element. Child elements are skipped.
+         */
+        bool read_text(std::string &out)
+        {
+            if (_empty)
+                return true;
+            for (bool found = false;;)
+            {
+                switch (next())
+                {
+                case node_text:
+                    if (!found && (_cdata || std::any_of(_text.begin(), _text.end(), [](char c)
+                                                         { return !is_space(c); })))
+                    {
+                        text(out);
+                        found = true;
+                    }
+                    break;
+                case node_element:
+                    if (!skip())
+                        return false;
+                    break;
+                case node_end_element:
+                    return true;
+                default:
+                    return false;
+                }
+            }
+        }
+
+        /**
+         * Append the text of the current rich text element (CT_Rst: si or is) and move past its end, as pugixml reads it:
+         * the runs' t elements joined when there are r elements, otherwise the first t element.
+         */
+        bool read_rich_text(std::string &out)
+        {
+            // <si><t>text</t></si> or <si><r><t>te</t></r><r><t>xt</t></r></si>
+            std::string t, runs;
+            bool has_t = false, has_r = false;
+            if (_empty)
+                return true;
+            for (;;)
+            {
+                auto node = next();
+                if (node == node_end_element)
+                    break;
+                if (node == node_text)
+                    continue;
+                if (node != node_element)
+                    return false;
+
+                if (_name == "t" && !has_t)
+                {
+                    has_t = true;
+                    if (!read_text(t))
+                        return false;
+                }
+                else if (_name == "r")
+                {
+                    has_r = true;
+                    bool has_rt = false;
+                    if (_empty)
+                        continue;
+                    for (;;)
+                    {
+                        auto child = next();
+                        if (child == node_end_element)
+                            break;
+                        if (child == node_text)
+                            continue;
+                        if (child != node_element)
+                            return false;
+                        if (_name == "t" && !has_rt)
+                        {
+                            has_rt = true;
+                            if (!read_text(runs))
+                                return false;
+                        }
+                        else if (!skip())
+                            return false;
+                    }
+                }
+                else if (!skip())
+                    return false;
+            }
+            out += has_r ? runs : t;
+            return true;
+        }
+
+        static void decode(std::string_view raw, std::string &out)
+        {
+            auto p = raw.data(), end = p + raw.size();
+            while (p < end)
+            {
+                auto run = p;
+                while (p < end && *p != '&' && *p != '\r')
+                    ++p;
+                out.append(run, p - run);
+                if (p == end)
+                    break;
+
+                if (*p == '\r')
+                {
+                    out += '\n';
+                    p += (p + 1 < end && p[1] == '\n') ? 2 : 1;
+                    continue;
+                }
+
+                auto semicolon = static_cast<const char *>(std::memchr(p, ';', end - p));
+                if (semicolon == nullptr)
+                {
+                    out.append(p, end - p);
+                    break;
+                }
+                std::string_view entity(p + 1, semicolon - p - 1);
+                if (entity == "lt")
+                    out += '<';
+                else if (entity == "gt")
+                    out += '>';
+                else if (entity == "amp")
+                    out += '&';
+                else if (entity == "quot")
+                    out += '"';
+                else if (entity == "apos")
+                    out += '\'';
+                else if (entity.size() > 1 && entity[0] == '#')
+                {
+                    unsigned long code = 0;
+                    bool hex = entity[1] == 'x', valid = entity.size() > (hex ? 2u : 1u);
+                    for (auto c : entity.substr(hex ? 2 : 1))
+                    {
+                        unsigned digit;
+                        if ('0' <= c && c <= '9')
+                            digit = c - '0';
+                        else if (hex && 'a' <= (c | 0x20) && (c | 0x20) <= 'f')
+                            digit = (c | 0x20) - 'a' + 10;
+                        else
+                        {
+                            valid = false;
+                            break;
+                        }
+                        code = code * (hex ? 16 : 10) + digit;
+                        if (code > 0x10FFFF)
+                        {
+                            valid = false;
+                            break;
+                        }
+                    }
+                    if (!valid)
+                    {
+                        out += '&';
+                        ++p;
+                        continue;
+                    }
+                    if (code < 0x80)
+                        out += static_cast<char>(code);
+                    else if (code < 0x800)
+                    {
+                        out += static_cast<char>(0xC0 | (code >> 6));
+                        out += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    else if (code < 0x10000)
+                    {
+                        out += static_cast<char>(0xE0 | (code >> 12));
+                        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        out += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    else
+                    {
+                        out += static_cast<char>(0xF0 | (code >> 18));
+                        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        out += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                }
+                else
+                {
+                    out += '&'; // unknown entity is kept as is
+                    ++p;
+                    continue;
+                }
+                p = semicolon + 1;
+            }
+        }
+    };
+
+    /**
+     * Read-only memory mapping of a whole file. All zip readers of a workbook share it, so the compressed data is read
+     * straight from the page cache instead of being copied through stdio buffers.
+     */
+    class file_mapping
+    {
+    private:
+        const char *_data = nullptr;
+        size_t _size = 0;
+#ifdef _WIN32
+        HANDLE _file = INVALID_HANDLE_VALUE;
+        HANDLE _mapping = nullptr;
+#endif
+
+    public:
+        file_mapping() noexcept = default;
+        file_mapping(const file_mapping &) = delete;
+        file_mapping &operator=(const file_mapping &) = delete;
+        ~file_mapping() { close(); }
+
+        bool open(const std::string &path) noexcept
+        {
+            close();
+#ifdef _WIN32
+            _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            LARGE_INTEGER size;
+            if (_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+                return close(), false;
+            _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (_mapping == nullptr)
+                return close(), false;
+            _data = static_cast<const char *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+            if (_data == nullptr)
+                return close(), false;
+            _size = static_cast<size_t>(size.QuadPart);
+#else
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size == 0)
+            {
+                ::close(fd);
+                return false;
+            }
+            auto data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd); // the mapping keeps the file open
+            if (data == MAP_FAILED)
+                return false;
+            madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            _data = static_cast<const char *>(data);
+            _size = static_cast<size_t>(st.st_size);
+#endif
+            return true;
+        }
+
+        void close() noexcept
+        {
+#ifdef _WIN32
+            if (_data)
+                UnmapViewOfFile(_data);
+            if (_mapping)
+                CloseHandle(_mapping);
+            if (_file != INVALID_HANDLE_VALUE)
+                CloseHandle(_file);
+            _mapping = nullptr;
+            _file = INVALID_HANDLE_VALUE;
+#else
+            if (_data)
+                munmap(const_cast<char *>(_data), _size);
+#endif
+            _data = nullptr;
+            _size = 0;
+        }
+
+        const char *data() const noexcept { return _data; }
+        size_t size() const noexcept { return _size; }
+        explicit operator bool() const noexcept { return _data != nullptr; }
+    };
+
+    /**
+     * A merged range of cells from first (top-left, the anchor holding the value) to last (bottom-right).
+     */
+    class merge_range
     {
     public:
+        reference first;
+        reference last;
+
+        bool contains(unsigned row, unsigned col) const noexcept { return first.row <= row && row <= last.row && first.col <= col && col <= last.col; }
+        bool contains(const reference &refer) const noexcept { return contains(refer.row, refer.col); }
+    };
+
+    /**
+     * A problem found while reading a worksheet: the cell it was found in ((0, 0) for the sheet itself) and a code with
+     * a static message, 12 bytes whatever the error.
+     */
+    class read_error
+    {
+    public:
+        enum code_type : std::uint8_t
+        {
+            open_failed,         // the part is missing or broken, no row was read
+            shared_string_index, // shared string index out of range
+            style_index,         // style index out of range
+            cell_error,          // error cell without a value
+            error_div0,          // #DIV/0!
+            error_na,            // #N/A
+            error_name,          // #NAME?
+            error_null,          // #NULL!
+            error_num,           // #NUM!
+            error_ref,           // #REF!
+            error_value,         // #VALUE!
+            error_getting_data,  // #GETTING_DATA
+            error_spill,         // #SPILL!
+            error_calc,          // #CALC!
+            error_other,         // any other error value, e.g. #FOO: worksheet::at(refer()) holds it
+            code_count,
+        };
+
         unsigned row;
         unsigned col;
+        code_type code;
 
-        reference() noexcept : reference(0, 0) {}
-        reference(unsigned row, unsigned col) noexcept : row(row), col(col) {}
-        reference(const std::string &value) noexcept { this->value(value); }
+        reference refer() const noexcept { return reference(row, col); }
+        const char *message() const noexcept { return message(code); }
+        static const char *message(code_type code) noexcept
+        {
+            static const char *const messages[code_count] = {
+                "workseet open failed", "shared string index out of range", "style index out of range", "cell error",
+                "#DIV/0!", "#N/A", "#NAME?", "#NULL!", "#NUM!", "#REF!", "#VALUE!", "#GETTING_DATA", "#SPILL!", "#CALC!",
+                "unknown error value"};
+            return code < code_count ? messages[code] : "";
+        }
+        /**
+         * Code of the error value v of a cell with t="e".
+         */
+        static code_type cell_error_code(std::string_view v) noexcept
+        {
+            if (v.empty())
+                return cell_error;
+            for (int code = error_div0; code < error_other; ++code)
+                if (v == message(code_type(code)))
+                    return code_type(code);
+            return error_other;
+        }
+    };
+
+    /**
+     * The errors of a worksheet read, in document order. Every error is counted by code, but only the first limit are
+     * kept, so a sheet with a systematic problem on a million cells costs a few counters past the limit.
+     */
+    class read_errors
+    {
+    private:
+        std::vector<read_error> _errors{};
+        size_t _counts[read_error::code_count]{};
+        size_t _limit = std::numeric_limits<size_t>::max();
+
+    public:
+        read_errors() noexcept {}
+        explicit read_errors(size_t limit) noexcept : _limit(limit) {}
 
-        void value(const std::string &value) noexcept
+        void add(unsigned row, unsigned col, read_error::code_type code)
         {
-            row = col = 0;
-            for (std::string::size_type i = 0; i < value.size(); ++i)
-            {
-                auto c = value[i];
-                if (row == 0 && 'A' <= c && c <= 'Z')
-                    col = col * 26 + (c - 'A') + 1;
-                else if (col > 0 && '0' <= c && c <= '9')
-                    row = row * 10 + (c - '0');
-                else
-                {
-                    row = col = 0;
-                    break;
-                }
-            }
+            ++_counts[code];
+            if (_errors.size() < _limit)
+                _errors.push_back({row, col, code});
         }
-        std::string value() const noexcept
+        /**
+         * Append the errors of a later part of the same sheet.
+         */
+        void append(const read_errors &other)
         {
-            std::string value = "";
-            if (row > 0 && col > 0)
-            {
-                auto col_ = col;
-                while (col_ > 0)
-                {
-                    char c = (col_ - 1) % 26 + 'A';
-                    value = c + value;
-                    col_ = (col_ - (c - 'A' + 1)) / 26;
-                }
-                value += std::to_string(row);
-            }
-            return value;
+            for (int i = 0; i < read_error::code_count; ++i)
+                _counts[i] += other._counts[i];
+            auto size = std::min(other._errors.size(), _limit - std::min(_limit, _errors.size()));
+            _errors.insert(_errors.end(), other._errors.begin(), other._errors.begin() + size);
+        }
+        void clear() noexcept
+        {
+            _errors.clear();
+            std::fill(std::begin(_counts), std::end(_counts), 0);
         }
 
-        operator bool() const noexcept { return row > 0 && col > 0; }
+        /**
+         * Number of errors kept, at most limit().
+         */
+        size_t size() const noexcept { return _errors.size(); }
+        bool empty() const noexcept { return _errors.empty(); }
+        size_t limit() const noexcept { return _limit; }
+        /**
+         * Number of errors found with code, kept or not.
+         */
+        size_t count(read_error::code_type code) const noexcept { return _counts[code]; }
+        /**
+         * Number of errors found, kept or not.
+         */
+        size_t total() const noexcept
+        {
+            size_t total = 0;
+            for (auto count : _counts)
+                total += count;
+            return total;
+        }
+        bool truncated() const noexcept { return total() > _errors.size(); }
+
+        const read_error &operator[](size_t i) const noexcept { return _errors[i]; }
+        std::vector<read_error>::const_iterator begin() const noexcept { return _errors.begin(); }
+        std::vector<read_error>::const_iterator end() const noexcept { return _errors.end(); }
     };
 
-    class cell
+    /**
+     * The used range of a worksheet as declared by its dimension element, e.g. A1:H100. Only a hint written by the
+     * producer: it may be missing (false), too large or too small.
+     */
+    class sheet_dimension
     {
     public:
-        reference refer;
-        std::string value;
-        cell(reference reference, std::string value = "") noexcept : refer(reference), value(value) {}
-        cell(std::string reference, std::string value = "") noexcept : refer(reference), value(value) {}
-        cell(unsigned row, unsigned col, std::string value = "") noexcept : refer(row, col), value(value) {}
+        reference first;
+        reference last;
+
+        unsigned rows() const noexcept { return *this ? last.row - first.row + 1 : 0; }
+        unsigned cols() const noexcept { return *this ? last.col - first.col + 1 : 0; }
+        explicit operator bool() const noexcept { return first && last; }
     };
 
-    class worksheet;
+    /**
+     * Point lookup over the merged ranges of a worksheet.
+     *
+     * A centered interval tree on rows: every node keeps the ranges crossing its center row sorted by first column, the
+     * others go to the child on their side. Ranges crossing one row cannot overlap, so a node costs one binary search and
+     * a lookup O(log² n) in the worst case, independent of the number of cells. Overlapping ranges (broken files) are
+     * still found thanks to a running maximum of the last column.
+     */
+    class merge_index
+    {
+    private:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        struct node
+        {
+            unsigned center;   // row crossed by all ranges of the node
+            size_t begin, end; // its ranges in _ranges, sorted by first column
+            size_t left = npos, right = npos;
+        };
+        std::vector<merge_range> _ranges{}; // grouped by node
+        std::vector<unsigned> _reach{};     // greatest last column of the node ranges up to each one
+        std::vector<node> _nodes{};
+        size_t _root = npos;
+
+        size_t build(std::vector<merge_range> &ranges, size_t begin, size_t end)
+        {
+            if (begin == end)
+                return npos;
+            auto middle = begin + (end - begin) / 2;
+            auto mid_row = [](const merge_range &range)
+            { return range.first.row + (range.last.row - range.first.row) / 2; };
+            std::nth_element(ranges.begin() + begin, ranges.begin() + middle, ranges.begin() + end, [&](const merge_range &a, const merge_range &b)
+                             { return mid_row(a) < mid_row(b); });
+            auto center = mid_row(ranges[middle]);
+
+            // [begin, before): above the center, [before, after): crossing it, [after, end): below it
+            auto before = std::partition(ranges.begin() + begin, ranges.begin() + end, [center](const merge_range &range)
+                                         { return range.last.row < center; }) - ranges.begin();
+            auto after = std::partition(ranges.begin() + before, ranges.begin() + end, [center](const merge_range &range)
+                                        { return range.first.row <= center; }) - ranges.begin();
+            std::sort(ranges.begin() + before, ranges.begin() + after, [](const merge_range &a, const merge_range &b)
+                      { return a.first.col < b.first.col; });
+
+            auto index = _nodes.size();
+            _nodes.push_back({center, _ranges.size(), _ranges.size() + (after - before)});
+            for (auto i = before; i < after; ++i)
+            {
+                _reach.push_back(i == before ? ranges[i].last.col : std::max(_reach.back(), ranges[i].last.col));
+                _ranges.push_back(ranges[i]);
+            }
+            auto left = build(ranges, begin, before);
+            auto right = build(ranges, after, end);
+            _nodes[index].left = left;
+            _nodes[index].right = right;
+            return index;
+        }
+
+    public:
+        merge_index() noexcept {}
+        explicit merge_index(std::vector<merge_range> ranges)
+        {
+            _ranges.reserve(ranges.size());
+            _reach.reserve(ranges.size());
+            _root = build(ranges, 0, ranges.size());
+        }
+
+        size_t size() const noexcept { return _ranges.size(); }
+        bool empty() const noexcept { return _ranges.empty(); }
+        /**
+         * All ranges, in no particular order.
+         */
+        const std::vector<merge_range> &ranges() const noexcept { return _ranges; }
+
+        /**
+         * The range covering a cell, nullptr if the cell is not merged.
+         */
+        const merge_range *find(unsigned row, unsigned col) const noexcept
+        {
+            for (auto i = _root; i != npos;)
+            {
+                auto &node = _nodes[i];
+                auto begin = _ranges.begin() + node.begin;
+                auto j = std::upper_bound(begin, _ranges.begin() + node.end, col, [](unsigned col, const merge_range &range)
+                                          { return col < range.first.col; }) - _ranges.begin();
+                while (j-- > static_cast<std::ptrdiff_t>(node.begin) && _reach[j] >= col)
+                    if (_ranges[j].contains(row, col))
+                        return &_ranges[j];
+                if (row == node.center)
+                    break;
+                i = row < node.center ? node.left : node.right;
+            }
+            return nullptr;
+        }
+        const merge_range *find(const reference &refer) const noexcept { return find(refer.row, refer.col); }
+    };
 
     class workbook
     {
+    public:
+        /**
+         * Read-at-offset callback for workbook(read_function, size): copy up to size bytes at offset into buffer and return
+         * the number of bytes copied. It is called from several threads when worksheets are read concurrently.
+         */
+        using read_function = std::function<size_t(std::uint64_t offset, void *buffer, size_t size)>;
+
     private:
+        // the source of the zip archive, one of: a file (optionally mapped), a memory buffer or a read callback
         const std::string _path;
+        const bool _memory_map = false;
+        file_mapping _mapping{};
+        const void *_data = nullptr;
+        size_t _data_size = 0;
+        read_function _read{};
+        std::uint64_t _read_size = 0;
         std::vector<worksheet> _worksheets;
 
         mz_zip_archive _archive{};
+        std::unordered_map<std::string, mz_uint> _file_index{}; // lower case entry name → file index, first entry wins
+        statistics *_statistics = nullptr;
+        size_t _error_limit = std::numeric_limits<size_t>::max();
 
         bool _date1904 = false;
-        std::vector<std::string> _shared_strings{}; // text
+        std::string _shared_strings{};                 // text of all shared strings back to back
+        std::vector<size_t> _shared_string_offsets{0}; // entry i is _shared_strings[offsets[i], offsets[i + 1])
+
+        // read(true): the shared strings part is kept as is and an entry is only decoded when it is first used
+        bool _lazy_shared_strings = false;
+        std::unique_ptr<char, void (*)(void *)> _shared_strings_xml{nullptr, mz_free};
+        size_t _shared_strings_xml_size = 0;
+        std::vector<size_t> _si_offsets{};                                // offset of every si element in the part
+        mutable std::unique_ptr<std::atomic<const std::string *>[]> _decoded{}; // decoded entry, nullptr until used
+        mutable std::deque<std::string> _decoded_strings{};               // stable storage of the decoded entries
+        mutable std::mutex _decode_mutex;
         std::map<unsigned, std::string> _numfmts =  // id code
             {{0, "General"},
              {1, "0"},
@@ -113,90 +1481,1034 @@ namespace xlsxtext
              {48, "##0.0E+0"},
              {49, "@"}};
         std::vector<unsigned> _cell_xfs{}; // id
-        std::map<std::string, std::unique_ptr<number_format>> _number_formats{};
+        std::map<std::string, std::unique_ptr<number_format>> _number_formats{}; // code compiled, nullptr for an invalid code
+
+        struct xf_format
+        {
+            const std::string *code;     // format code of the cellXfs entry
+            const number_format *format; // compiled code, nullptr if it is invalid
+        };
+        std::vector<xf_format> _xf_formats{}; // indexed by the s attribute of a cell
+
+        /**
+         * Resolve the format of every cellXfs entry once after styles are loaded, so formatting a cell is one
+         * array index and never mutates the workbook (worksheets can be read concurrently).
+         */
+        void _compile_formats()
+        {
+            _number_formats.clear();
+            _xf_formats.clear();
+            _xf_formats.reserve(_cell_xfs.size());
+            for (auto xf : _cell_xfs)
+            {
+                auto it = _numfmts.find(xf);
+                const auto &format_string = it != _numfmts.end() ? it->second : std::string();
+                auto compiled = _number_formats.find(format_string);
+                if (compiled == _number_formats.end())
+                {
+                    std::unique_ptr<number_format> format;
+                    try
+                    {
+                        format = std::make_unique<number_format>(format_string);
+                    }
+                    catch (const std::exception &)
+                    {
+                        // reported when a cell uses it
+                    }
+                    compiled = _number_formats.emplace(format_string, std::move(format)).first;
+                }
+                _xf_formats.push_back({&compiled->first, compiled->second.get()});
+            }
+        }
+        static long _to_long(const std::string &value)
+        {
+            // std::stol without the temporary conversions, throwing the same exceptions
+            auto p = value.data(), end = p + value.size();
+            while (p < end && std::isspace(static_cast<unsigned char>(*p)))
+                ++p;
+            if (p < end && *p == '+')
+                ++p;
+            long result = 0;
+            auto parsed = std::from_chars(p, end, result);
+            if (parsed.ec == std::errc::invalid_argument)
+                throw std::invalid_argument("stol");
+            if (parsed.ec == std::errc::result_out_of_range)
+                throw std::out_of_range("stol");
+            return result;
+        }
+
+        /**
+         * Record the offset of every si element of the shared strings part without decoding any, false if it is broken.
+         */
+        bool _scan_shared_strings()
+        {
+            auto data = _shared_strings_xml.get();
+            xml_reader xml(data, data + _shared_strings_xml_size);
+            _si_offsets.clear();
+            unsigned depth = 0;
+            bool sst = false;
+            for (auto at = xml.position();; at = xml.position())
+            {
+                switch (xml.next())
+                {
+                case xml_reader::node_element:
+                    if (depth == 0)
+                        sst = xml.name() == "sst";
+                    else if (depth == 1 && sst && xml.name() == "si")
+                        _si_offsets.push_back(at - data);
+                    if (!xml.empty_element())
+                        ++depth;
+                    break;
+                case xml_reader::node_end_element:
+                    if (depth == 0)
+                        return false;
+                    --depth;
+                    break;
+                case xml_reader::node_text:
+                    break;
+                case xml_reader::node_end:
+                    return depth == 0;
+                default:
+                    return false;
+                }
+            }
+        }
+        const std::string &_decode_shared_string(size_t index) const
+        {
+            std::lock_guard<std::mutex> lock(_decode_mutex);
+            if (auto decoded = _decoded[index].load(std::memory_order_relaxed))
+            {
+                if (_statistics)
+                    _statistics->add(_statistics->shared_string_hits, 1);
+                return *decoded;
+            }
+            if (_statistics)
+                _statistics->add(_statistics->shared_string_misses, 1);
+
+            auto data = _shared_strings_xml.get();
+            xml_reader xml(data + _si_offsets[index], data + _shared_strings_xml_size);
+            auto &text = _decoded_strings.emplace_back();
+            xml.next();
+            xml.read_rich_text(text);
+            _decoded[index].store(&text, std::memory_order_release);
+            return text;
+        }
+
+        static void _lower(std::string &name) noexcept
+        {
+            for (auto &c : name)
+                if ('A' <= c && c <= 'Z')
+                    c = static_cast<char>(c - 'A' + 'a');
+        }
+        /**
+         * Hash the names of all entries once, so that resolving a part never searches the central directory.
+         * Names are matched case-insensitively like mz_zip_reader_locate_file.
+         */
+        void _index_files()
+        {
+            _file_index.clear();
+            auto count = mz_zip_reader_get_num_files(&_archive);
+            _file_index.reserve(count);
+            std::string name;
+            for (mz_uint i = 0; i < count; ++i)
+            {
+                name.resize(mz_zip_reader_get_filename(&_archive, i, nullptr, 0));
+                if (name.empty())
+                    continue;
+                name.resize(mz_zip_reader_get_filename(&_archive, i, &name[0], static_cast<mz_uint>(name.size())) - 1);
+                _lower(name);
+                _file_index.emplace(name, i);
+            }
+        }
+        /**
+         * File index of an entry (the same in every zip reader of the workbook), -1 if there is none.
+         */
+        int _locate(const std::string &path) const
+        {
+            std::string name = path;
+            _lower(name);
+            auto it = _file_index.find(name);
+            return it == _file_index.end() ? -1 : static_cast<int>(it->second);
+        }
+
+        /**
+         * Open a zip reader over the workbook file (or its mapping); every reader is independent, so each thread can own one.
+         */
+        bool _open_archive(mz_zip_archive &archive) const noexcept
+        {
+            archive = mz_zip_archive{};
+            if (_mapping)
+                return mz_zip_reader_init_mem(&archive, _mapping.data(), _mapping.size(), 0);
+            if (_data)
+                return mz_zip_reader_init_mem(&archive, _data, _data_size, 0);
+            if (_read)
+            {
+                archive.m_pRead = [](void *opaque, mz_uint64 offset, void *buffer, size_t size) -> size_t
+                {
+                    try
+                    {
+                        return static_cast<const workbook *>(opaque)->_read(offset, buffer, size);
+                    }
+                    catch (...)
+                    {
+                        return 0; // reported by miniz as a read failure
+                    }
+                };
+                archive.m_pIO_opaque = const_cast<workbook *>(this);
+                return mz_zip_reader_init(&archive, _read_size, 0);
+            }
+            return mz_zip_reader_init_file(&archive, _path.c_str(), 0);
+        }
+
+        /**
+         * How a cell read as text is formatted: 0 not through a number format, 1 with its compiled format, 2 by parsing
+         * a format code that failed to compile.
+         */
+        int _format_kind(const raw_cell &cell) const noexcept
+        {
+            if (cell.formula || cell._xf < 0)
+                return 0;
+            return _xf_formats[cell._xf].format ? 1 : 2;
+        }
+
+        void _count_part(mz_zip_archive &archive, int index, const std::string &path, bool inflated) const
+        {
+            mz_zip_archive_file_stat stat;
+            if (!mz_zip_reader_file_stat(&archive, index, &stat))
+                return;
+            _statistics->add_part(path, stat.m_comp_size, inflated ? stat.m_uncomp_size : 0);
+            if (inflated)
+                _statistics->add(_statistics->allocations, 1);
+        }
+
+        struct memory_source
+        {
+            const void *data;
+            size_t size;
+        };
+        workbook(memory_source source) noexcept : _data(source.data), _data_size(source.size) {}
+
+        friend class worksheet;
+        friend class sheet_reader;
+
+    public:
+        /**
+         * With memory_map, the file is mapped into memory (mmap / MapViewOfFile) when it is read and the zip readers
+         * work on the mapping instead of reading the file through stdio.
+         */
+        workbook(const std::string &path, bool memory_map = false) noexcept : _path(path), _memory_map(memory_map) {}
+        /**
+         * Read the workbook from an xlsx file held in memory, without copying it. The buffer must outlive the workbook.
+         * A named factory rather than a constructor, so that workbook("book.xlsx", true) cannot bind to a buffer.
+         */
+        static workbook from_memory(const void *data, size_t size) noexcept { return workbook(memory_source{data, size}); }
+        /**
+         * Read the workbook of size bytes through read (e.g. a ranged reader over object storage).
+         */
+        workbook(read_function read, std::uint64_t size) noexcept : _read(std::move(read)), _read_size(size) {}
+        ~workbook() { mz_zip_reader_end(&_archive); }
+
+        bool read() noexcept { return read(false); }
+        /**
+         * With lazy_shared_strings, the shared strings part is only scanned for the position of its entries and an entry
+         * is decoded the first time a cell uses it, so opening a workbook with a huge table to read one sheet stays cheap.
+         */
+        bool read(bool lazy_shared_strings) noexcept;
+
+        /**
+         * Fill stats (nullptr: stop) from now on: read() and every worksheet read add their phase times, part bytes and counters.
+         * The object must outlive the reads; it is not reset here.
+         */
+        void collect_statistics(statistics *stats) noexcept { _statistics = stats; }
+        statistics *collected_statistics() const noexcept { return _statistics; }
+
+        /**
+         * Keep at most limit errors per worksheet read from now on; the others are only counted (read_errors::count).
+         */
+        void limit_errors(size_t limit) noexcept { _error_limit = limit; }
+        size_t error_limit() const noexcept { return _error_limit; }
+
+        void *extract_file(const std::string &path, size_t *size)
+        {
+            auto index = _locate(path);
+            if (index < 0)
+                return nullptr;
+            statistics::timer timer(_statistics, statistics::phase_inflate);
+            auto buffer = mz_zip_reader_extract_to_heap(&_archive, index, size, 0);
+            timer.stop();
+            if (_statistics)
+                _count_part(_archive, index, path, buffer != nullptr);
+            return buffer;
+        }
+        mz_zip_reader_extract_iter_state *extract_file_iter(const std::string &path)
+        {
+            auto index = _locate(path);
+            return index < 0 ? nullptr : mz_zip_reader_extract_iter_new(&_archive, index, 0);
+        }
+
+        /**
+         * Read all worksheets concurrently with up to threads workers (0: one per hardware thread), each using its own zip reader.
+         * Rows are stored in the worksheets as by worksheet::read(); the errors are returned in sheet order.
+         * An exception thrown while reading a sheet is rethrown after all workers finished.
+         */
+        std::vector<read_errors> read_all(unsigned threads = 0);
+        bool file_exists(const std::string &path) { return _locate(path) >= 0; }
+
+        std::string read_value(const std::string &v, const std::string &t, const std::string &s, std::string &error) const
+        {
+            raw_cell cell;
+            read_raw_value(cell, v, t, s, error);
+            return text(cell);
+        }
+
+        /**
+         * Type the value v of a cell with type t and style s into cell without formatting it.
+         * A formula cell (cell.formula set) keeps its cached value as stored and is never checked or formatted,
+         * as does an explicit number (t="n"), whose style is ignored.
+         */
+        void read_raw_value(raw_cell &cell, const std::string &v, const std::string &t, const std::string &s, std::string &error) const
+        {
+            auto code = read_error::code_count;
+            read_raw_value(cell, v, t, s, code);
+            if (code == read_error::error_other)
+                error = v;
+            else if (code != read_error::code_count)
+                error = read_error::message(code);
+        }
+        /**
+         * As above, setting code (left alone when the cell is fine) instead of building a message.
+         */
+        void read_raw_value(raw_cell &cell, const std::string &v, const std::string &t, const std::string &s, read_error::code_type &code) const
+        {
+            cell._workbook = this;
+            cell._xf = -1;
+            cell.number = 0;
+            cell.index = 0;
+            cell.raw = v;
+            if (t == "str" || t == "inlineStr")
+            {
+                cell.type = raw_cell::type_string;
+            }
+            else if (t == "b")
+            {
+                cell.type = raw_cell::type_boolean;
+                cell.number = v == "0" ? 0 : 1;
+            }
+            else if (t == "s")
+            {
+                if (cell.formula)
+                {
+                    cell.type = raw_cell::type_string;
+                    return;
+                }
+                auto index = _to_long(v);
+                if (index < 0 || static_cast<std::size_t>(index) >= shared_string_count())
+                {
+                    code = read_error::shared_string_index;
+                    cell.type = raw_cell::type_empty;
+                    cell.raw.clear();
+                    return;
+                }
+                cell.type = raw_cell::type_shared_string;
+                cell.index = static_cast<unsigned>(index);
+            }
+            else if (t == "d")
+            {
+                // ISO 8601 date format: kept as-is
+                cell.type = raw_cell::type_date;
+            }
+            else if (t == "e")
+            {
+                // Specific Excel error values: #DIV/0!, #N/A, #NAME?, #NULL!, #NUM!, #REF!, #VALUE!
+                cell.type = raw_cell::type_error;
+                if (!cell.formula)
+                    code = read_error::cell_error_code(v);
+            }
+            else
+            {
+                char *end = nullptr;
+                const char *str = v.c_str();
+                cell.number = std::strtod(str, &end);
+                if (end != str && *end == '\0')
+                    cell.type = raw_cell::type_number;
+                else
+                {
+                    cell.type = v.empty() ? raw_cell::type_empty : raw_cell::type_string;
+                    cell.number = 0;
+                }
+
+                if (cell.formula || t == "n" || s == "")
+                    return;
+
+                auto index = _to_long(s);
+                if (index < 0 || static_cast<std::size_t>(index) >= _xf_formats.size())
+                {
+                    code = read_error::style_index;
+                    return;
+                }
+                cell._xf = index;
+            }
+        }
+
+        /**
+         * Display text of a cell typed by read_raw_value, formatted with its number format.
+         */
+        std::string text(const raw_cell &cell) const
+        {
+            if (cell.formula)
+                return cell.raw;
+            switch (cell.type)
+            {
+            case raw_cell::type_boolean:
+                return cell.number == 0 ? "FALSE" : "TRUE";
+            case raw_cell::type_shared_string:
+                return std::string(shared_string(cell.index));
+            case raw_cell::type_error:
+                return cell.raw.empty() ? "#ERROR!" : cell.raw;
+            default:
+                break;
+            }
+            if (cell._xf < 0)
+                return cell.raw;
+
+            const auto &xf = _xf_formats[cell._xf];
+            if (cell.type == raw_cell::type_number)
+                return xf.format ? xf.format->format(cell.number, _date1904) : number_format(*xf.code).format(cell.number, _date1904);
+            else
+                return xf.format ? xf.format->format(cell.raw) : number_format(*xf.code).format(cell.raw);
+        }
+
+        size_t shared_string_count() const noexcept { return _lazy_shared_strings ? _si_offsets.size() : _shared_string_offsets.size() - 1; }
+        /**
+         * Entry of the shared string table, a view into the workbook valid until it is read again or destroyed.
+         * Safe to call from several threads; in lazy mode the first call for an entry decodes it.
+         */
+        std::string_view shared_string(size_t index) const
+        {
+            if (_lazy_shared_strings)
+            {
+                auto decoded = _decoded[index].load(std::memory_order_acquire);
+                if (!decoded)
+                    return _decode_shared_string(index);
+                if (_statistics)
+                    _statistics->add(_statistics->shared_string_hits, 1);
+                return *decoded;
+            }
+            auto begin = _shared_string_offsets[index];
+            return std::string_view(_shared_strings.data() + begin, _shared_string_offsets[index + 1] - begin);
+        }
+
+        const std::vector<worksheet> &worksheets() const noexcept { return _worksheets; }
+        std::vector<worksheet>::const_iterator begin() const noexcept { return _worksheets.begin(); }
+        std::vector<worksheet>::const_iterator end() const noexcept { return _worksheets.end(); }
+    };
+
+    inline std::string raw_cell::text() const { return _workbook ? _workbook->text(*this) : raw; }
+    inline std::string_view raw_cell::string() const
+    {
+        return type == type_shared_string && _workbook ? _workbook->shared_string(index) : std::string_view(raw);
+    }
+
+    /**
+     * Sequential reader over one zip entry, inflated in fixed-size chunks with mz_zip_reader_extract_iter_*.
+     *
+     * Entries larger than the chunk ring are inflated on a background thread into chunk_count buffers of chunk_size bytes,
+     * so decompression overlaps with parsing while the working set stays bounded regardless of the entry size.
+     */
+    class part_reader
+    {
+    public:
+        static constexpr size_t chunk_size = 64 * 1024;
+        static constexpr size_t chunk_count = 4;
+
+    private:
+        mz_zip_reader_extract_iter_state *_state;
+        statistics *_statistics;
+        std::string _name;
+        std::atomic<std::uint64_t> _inflate_ns{0}; // written by the inflating thread
+
+        std::unique_ptr<char[]> _chunks{};
+        size_t _sizes[chunk_count]{};
+        size_t _head = 0;   // chunk being consumed
+        size_t _offset = 0; // consumed bytes of the head chunk
+        size_t _filled = 0; // inflated chunks not yet consumed
+        bool _cancel = false;
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        std::thread _thread;
+
+        void inflate()
+        {
+            for (size_t tail = 0;; tail = (tail + 1) % chunk_count)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _cv.wait(lock, [this]
+                             { return _cancel || _filled < chunk_count; });
+                    if (_cancel)
+                        return;
+                }
+                auto size = extract(&_chunks[tail * chunk_size], chunk_size);
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _sizes[tail] = size;
+                    ++_filled;
+                }
+                _cv.notify_all();
+                if (size == 0)
+                    return;
+            }
+        }
+        size_t extract(char *buffer, size_t size)
+        {
+            if (!_statistics)
+                return mz_zip_reader_extract_iter_read(_state, buffer, size);
+            auto start = statistics::now();
+            size = mz_zip_reader_extract_iter_read(_state, buffer, size);
+            _inflate_ns.fetch_add(statistics::now() - start, std::memory_order_relaxed);
+            return size;
+        }
+        /**
+         * Free the entry after adding what was read to the statistics.
+         */
+        bool release()
+        {
+            if (!_state)
+                return false;
+            if (_statistics)
+            {
+                _statistics->add_time(statistics::phase_inflate, _inflate_ns.load());
+                _statistics->add_part(_name, _state->file_stat.m_comp_size - _state->comp_remaining, _state->out_buf_ofs);
+                _statistics->add(_statistics->allocations, _chunks ? 1 : 0);
+            }
+            auto ok = mz_zip_reader_extract_iter_free(_state);
+            _state = nullptr;
+            return ok;
+        }
+        void stop()
+        {
+            if (_thread.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _cancel = true;
+                }
+                _cv.notify_all();
+                _thread.join();
+            }
+        }
+
+    public:
+        /**
+         * Read the entry of state, adding the time and bytes inflated to stats (if any) under name.
+         */
+        explicit part_reader(mz_zip_reader_extract_iter_state *state, statistics *stats = nullptr, const std::string &name = "")
+            : _state(state), _statistics(stats), _name(stats ? name : std::string())
+        {
+            if (_state && _state->file_stat.m_uncomp_size > chunk_count * chunk_size)
+            {
+                _chunks.reset(new char[chunk_count * chunk_size]);
+                _thread = std::thread(&part_reader::inflate, this);
+            }
+        }
+        ~part_reader()
+        {
+            stop();
+            release();
+        }
+        part_reader(const part_reader &) = delete;
+        part_reader &operator=(const part_reader &) = delete;
+
+        explicit operator bool() const noexcept { return _state != nullptr; }
 
-        std::string _format(std::string format_string, const std::string &text)
+        /**
+         * Copy up to size inflated bytes into buffer, 0 at the end of the entry (or on a decompression error, see close()).
+         */
+        size_t read(char *buffer, size_t size)
         {
-            auto it = _number_formats.find(format_string);
-            if (it == _number_formats.end())
-                it = _number_formats.emplace(format_string, std::make_unique<number_format>(format_string)).first;
-            return it->second->format(text);
+            if (!_thread.joinable())
+                return extract(buffer, size);
+
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this]
+                     { return _filled > 0; });
+            auto available = _sizes[_head] - _offset;
+            lock.unlock();
+            if (available == 0)
+                return 0;
+
+            size = std::min(size, available);
+            std::memcpy(buffer, &_chunks[_head * chunk_size + _offset], size);
+            if ((_offset += size) == _sizes[_head])
+            {
+                lock.lock();
+                _head = (_head + 1) % chunk_count;
+                _offset = 0;
+                --_filled;
+                lock.unlock();
+                _cv.notify_all();
+            }
+            return size;
         }
-        std::string _format(std::string format_string, double number)
+
+        /**
+         * Release the entry, true if it was inflated completely and its CRC matches.
+         */
+        bool close()
         {
-            auto it = _number_formats.find(format_string);
-            if (it == _number_formats.end())
-                it = _number_formats.emplace(format_string, std::make_unique<number_format>(format_string)).first;
-            return it->second->format(number, _date1904);
+            stop();
+            return release();
         }
+    };
 
+    /**
+     * Forward-only pull parser for a worksheet part, specialised for CT_SheetData (row, c, v, is, f) and CT_MergeCells.
+     *
+     * The part is fed in pieces of any size; each row is converted with workbook::read_value and handed to the callback
+     * as soon as its end tag is scanned, so the only per-sheet state is the current row plus an incomplete tail.
+     * Elements outside of worksheet/sheetData/row/c and worksheet/mergeCells/mergeCell are skipped without being interpreted.
+     */
+    class sheet_reader
+    {
     public:
-        workbook(const std::string &path) noexcept : _path(path) {}
-        ~workbook() { mz_zip_reader_end(&_archive); }
+        using merge_cell = merge_range;
+
+    private:
+        enum state_type
+        {
+            state_document,
+            state_worksheet,
+            state_sheet_data,
+            state_merge_cells,
+            state_done,
+        };
+
+        workbook &_workbook;
+        read_errors &_errors;
+        std::vector<merge_cell> &_merge_cells;
+        sheet_dimension &_dimension;
 
-        bool read() noexcept;
+        state_type _state = state_document;
+        unsigned _skip_depth = 0; // depth inside an element that is being skipped
+        bool _sheet_data = false;
+        bool _merge_cells_read = false;
+        bool _stopped = false;
+        bool _failed = false;
+        bool _raw = false; // rows are handed out as raw_cell, not formatted
+        const columns *_columns = nullptr;
+        row_range _range;
+        size_t _row_count = 0; // rows handed out
+
+        // counted locally and added to the workbook statistics once, by the destructor
+        struct cell_counts
+        {
+            std::uint64_t cells[statistics::cell_type_count]{};
+            std::uint64_t format_hits = 0, format_misses = 0;
+        };
+        statistics *_statistics;
+        std::uint64_t _parse_ns = 0, _format_ns = 0, _formatted = 0;
+        std::uint64_t _rows_read = 0, _allocations = 0;
+        cell_counts _counts{};
+        cell_counts _row_counts{}; // of the current row, committed with its errors once the row is complete
+        size_t _capacity = 0; // of the row buffer after the last cell, a change means it was reallocated
 
-        void *extract_file(const std::string &path, size_t *size) { return mz_zip_reader_extract_file_to_heap(&_archive, path.c_str(), size, 0); }
-        bool file_exists(const std::string &path) { return mz_zip_reader_locate_file(&_archive, path.c_str(), nullptr, 0) != -1;}
+        unsigned _row_index = 0;
+        unsigned _col_index = 0;
+        std::vector<cell> _cells{};
+        std::vector<raw_cell> _raw_cells{};
+        raw_cell _cell{}; // typed value of the current cell when reading text
+        std::vector<read_error> _row_errors{}; // committed once the row is complete
+        std::string _r{}, _s{}, _t{}, _v{};
 
-        std::string read_value(const std::string &v, const std::string &t, const std::string &s, std::string &error)
+        static void assign(std::string &out, std::string_view raw)
+        {
+            out.clear();
+            xml_reader::decode(raw, out);
+        }
+        /**
+         * Parse the range "A1:C3" of attribute raw into its top-left and bottom-right cells, a single cell "A1" too with single.
+         */
+        static bool read_range(std::string_view raw, reference &first, reference &last, bool single)
+        {
+            std::string refs;
+            xml_reader::decode(raw, refs);
+            auto split = refs.find(':');
+            if (split == std::string::npos ? !single : split == refs.size() - 1)
+                return false;
+            reference a(refs.substr(0, split)), b(split == std::string::npos ? refs : refs.substr(split + 1));
+            if (!a || !b)
+                return false;
+            first = reference(std::min(a.row, b.row), std::min(a.col, b.col));
+            last = reference(std::max(a.row, b.row), std::max(a.col, b.col));
+            return true;
+        }
+        /**
+         * Presize the row buffer with the first row, from its spans="1:52" or else the dimension of the sheet.
+         */
+        void reserve_row(xml_reader &xml)
         {
-            if (t == "n" || t == "str" || t == "inlineStr")
+            unsigned width = _dimension.cols();
+            std::string spans;
+            xml_reader::decode(xml.attribute("spans"), spans);
+            auto split = spans.find(':');
+            if (split != std::string::npos)
             {
-                return v;
+                auto lo = std::strtoul(spans.c_str(), nullptr, 10), hi = std::strtoul(spans.c_str() + split + 1, nullptr, 10);
+                if (0 < lo && lo <= hi)
+                    width = static_cast<unsigned>(std::min<unsigned long>(hi - lo + 1, reference::max_col));
             }
-            else if (t == "b")
+            width = std::min(width, reference::max_col);
+            if (_raw)
+                _raw_cells.reserve(width);
+            else
+                _cells.reserve(width);
+        }
+        static unsigned to_unsigned(const std::string &value)
+        {
+            return static_cast<unsigned>(std::stol(value));
+        }
+        static statistics::cell_type cell_type(const std::string &t) noexcept
+        {
+            if (t == "s")
+                return statistics::cell_shared_string;
+            if (t == "b")
+                return statistics::cell_boolean;
+            if (t == "e")
+                return statistics::cell_error;
+            if (t == "str")
+                return statistics::cell_string;
+            if (t == "inlineStr")
+                return statistics::cell_inline_string;
+            if (t == "d")
+                return statistics::cell_date;
+            return statistics::cell_number;
+        }
+        static bool allocated(const std::string &value) noexcept { return value.capacity() > std::string().capacity(); }
+
+        /**
+         * Count a cell for the statistics and format it, timing every 16th formatted value.
+         */
+        void count_and_push(const raw_cell &value)
+        {
+            ++_row_counts.cells[cell_type(_t)];
+            auto kind = _raw ? 0 : _workbook._format_kind(value);
+            _row_counts.format_hits += kind == 1;
+            _row_counts.format_misses += kind == 2;
+
+            if (_raw)
+                _allocations += allocated(value.raw);
+            else if (++_formatted % 16 == 0)
             {
-                return v == "0" ? "FALSE" : "TRUE";
+                auto start = statistics::now();
+                _cells.push_back(cell(value.refer, _workbook.text(value)));
+                _format_ns += (statistics::now() - start) * 16;
             }
-            else if (t == "s")
+            else
+                _cells.push_back(cell(value.refer, _workbook.text(value)));
+            if (!_raw)
+                _allocations += allocated(_cells.back().value);
+            auto capacity = _raw ? _raw_cells.capacity() : _cells.capacity();
+            _allocations += capacity != _capacity;
+            _capacity = capacity;
+        }
+
+        bool read_cell(xml_reader &xml)
+        {
+            auto r = xml.attribute("r");
+            reference refer(r); // "r" is optional
+            if (!refer && r.find('&') != std::string_view::npos)
             {
-                auto index = std::stol(v);
-                if (index < 0 || static_cast<std::size_t>(index) >= _shared_strings.size())
-                {
-                    error = "shared string index out of range";
-                    return "";
-                }
-                return _shared_strings[index];
+                assign(_r, r);
+                refer.value(_r);
             }
-            else if (t == "d")
+            if (!refer)
             {
-                // ISO 8601 date format: return as-is for text reading
-                return v;
+                refer.row = _row_index;
+                refer.col = ++_col_index;
             }
-            else if (t == "e")
+            _col_index = refer.col;
+
+            if (refer.row != _row_index) // Error in Microsoft Excel
+                return xml.skip();
+            if (_columns && !_columns->contains(refer.col))
+                return xml.skip();
+
+            assign(_s, xml.attribute("s"));
+            assign(_t, xml.attribute("t"));
+            _v.clear();
+
+            bool has_f = false, has_v = false, has_is = false;
+            if (!xml.empty_element())
             {
-                // Return specific Excel error values: #DIV/0!, #N/A, #NAME?, #NULL!, #NUM!, #REF!, #VALUE!
-                error = v.empty() ? "cell error" : v;
-                return v.empty() ? "#ERROR!" : v;
+                for (;;)
+                {
+                    auto node = xml.next();
+                    if (node == xml_reader::node_end_element)
+                        break;
+                    if (node == xml_reader::node_text)
+                        continue;
+                    if (node != xml_reader::node_element)
+                        return false;
+
+                    bool ok;
+                    if (xml.name() == "f")
+                    {
+                        has_f = true;
+                        ok = xml.skip();
+                    }
+                    else if (xml.name() == "v" && !has_v && _t != "inlineStr")
+                    {
+                        has_v = true;
+                        ok = xml.read_text(_v);
+                    }
+                    else if (xml.name() == "is" && !has_is && _t == "inlineStr")
+                    {
+                        /**
+                         * (Ecma Office Open XML Part 1)
+                         *
+                         * when the cell's type t is inlineStr then only the element is is allowed as a child element.
+                         *
+                         * Cell containing an (inline) rich string, i.e., one not in the shared string table. If this cell type is used, then the cell value is in the is element rather than the v element in the cell (c element).
+                         */
+                        has_is = true;
+                        ok = xml.read_rich_text(_v);
+                    }
+                    else
+                        ok = xml.skip();
+                    if (!ok)
+                        return false;
+                }
             }
-            else
+
+            auto error = read_error::code_count;
+            auto &value = _raw ? _raw_cells.emplace_back() : _cell;
+            value.refer = refer;
+            value.formula = has_f;
+            _workbook.read_raw_value(value, _v, _t, _s, error);
+            if (error != read_error::code_count)
+                _row_errors.push_back({refer.row, refer.col, error});
+            if (_statistics)
+                count_and_push(value);
+            else if (!_raw)
+                _cells.push_back(cell(refer, _workbook.text(value)));
+            return true;
+        }
+
+        /**
+         * Parse one complete row element. Returns false when the buffer ends (or breaks) inside the row.
+         */
+        bool read_row(xml_reader &xml)
+        {
+            assign(_r, xml.attribute("r"));
+            _row_index = _r == "" ? _row_index + 1 : to_unsigned(_r);
+            _col_index = 0;
+
+            _cells.clear();
+            _raw_cells.clear();
+            _row_errors.clear();
+            _row_counts = {};
+            if (_row_index > _range.last) // feed stops here
+                return true;
+            if (_row_index < _range.first)
+                return xml.skip();
+            if ((_raw ? _raw_cells.capacity() : _cells.capacity()) == 0)
+                reserve_row(xml);
+            if (!xml.empty_element())
             {
-                if (s == "")
-                    return v;
+                for (;;)
+                {
+                    auto node = xml.next();
+                    if (node == xml_reader::node_end_element)
+                        break;
+                    if (node == xml_reader::node_text)
+                        continue;
+                    if (node != xml_reader::node_element)
+                        return false;
+                    if (!(xml.name() == "c" ? read_cell(xml) : xml.skip()))
+                        return false;
+                }
+            }
+            for (auto &error : _row_errors)
+                _errors.add(error.row, error.col, error.code);
+            for (int i = 0; i < statistics::cell_type_count; ++i)
+                _counts.cells[i] += _row_counts.cells[i];
+            _counts.format_hits += _row_counts.format_hits;
+            _counts.format_misses += _row_counts.format_misses;
+            return true;
+        }
+
+    public:
+        sheet_reader(workbook &wb, read_errors &errors, std::vector<merge_cell> &merge_cells, sheet_dimension &dimension,
+                     const columns &cols = {}, const row_range &range = {}) noexcept
+            : _workbook(wb), _errors(errors), _merge_cells(merge_cells), _dimension(dimension), _columns(cols.empty() ? nullptr : &cols), _range(range), _statistics(wb._statistics) {}
+        ~sheet_reader()
+        {
+            if (!_statistics)
+                return;
+            _format_ns = std::min(_format_ns, _parse_ns);
+            _statistics->add_time(statistics::phase_parse, _parse_ns - _format_ns);
+            _statistics->add_time(statistics::phase_format, _format_ns);
+            for (int i = 0; i < statistics::cell_type_count; ++i)
+                _statistics->add(_statistics->cells[i], _counts.cells[i]);
+            _statistics->add(_statistics->rows, _rows_read);
+            _statistics->add(_statistics->format_hits, _counts.format_hits);
+            _statistics->add(_statistics->format_misses, _counts.format_misses);
+            _statistics->add(_statistics->allocations, _allocations);
+        }
+        sheet_reader(const sheet_reader &) = delete;
+        sheet_reader &operator=(const sheet_reader &) = delete;
+
+        /**
+         * True once nothing more needs to be fed: the worksheet element is closed, the callback stopped or the markup is broken.
+         */
+        bool done() const noexcept { return _state == state_done; }
+        bool stopped() const noexcept { return _stopped; }
+        bool failed() const noexcept { return _failed; }
+
+        /**
+         * Start inside sheetData, for a piece of the part that was split just before a row element.
+         */
+        void start_in_sheet_data() noexcept
+        {
+            _state = state_sheet_data;
+            _sheet_data = true;
+        }
+
+        /**
+         * Parse the next piece of the part, calling bool on_row(unsigned row, std::vector<cell> &cells) for every non-empty row.
+         * The cells vector is the parser's own row buffer and is reused for the next row; returning false stops the scan.
+         * A callback taking std::vector<raw_cell> & gets the typed values instead and no cell is formatted.
+         *
+         * Returns the number of bytes consumed. An incomplete row or tag at the end of the piece is not consumed and must be
+         * fed again followed by the next bytes of the part; final marks the last piece.
+         */
+        template <typename Callback>
+        size_t feed(const char *data, size_t size, bool final, Callback &&on_row)
+        {
+            constexpr bool raw = std::is_invocable_v<Callback &, unsigned, std::vector<raw_cell> &>;
+            _raw = raw;
+            auto start = _statistics ? statistics::now() : 0;
 
-                auto index = std::stol(s);
-                if (index < 0 || static_cast<std::size_t>(index) >= _cell_xfs.size())
+            xml_reader xml(data, data + size, final);
+            auto consumed = data;
+            while (_state != state_done)
+            {
+                auto node = xml.next();
+                if (node == xml_reader::node_end)
+                    break;
+                if (node == xml_reader::node_malformed)
                 {
-                    error = "style index out of range";
-                    return v;
+                    _failed = true;
+                    _state = state_done;
+                    break;
                 }
-                auto xf = _cell_xfs[index];
-                const auto &fmt = _numfmts.find(xf) != _numfmts.end() ? _numfmts.at(xf) : "";
 
-                char *end = nullptr;
-                const char *str = v.c_str();
-                auto number = std::strtod(str, &end);
-                if (end != str && *end == '\0')
-                    return _format(fmt, number);
-                else
-                    return _format(fmt, v);
+                if (_skip_depth)
+                {
+                    if (node == xml_reader::node_element && !xml.empty_element())
+                        ++_skip_depth;
+                    else if (node == xml_reader::node_end_element)
+                        --_skip_depth;
+                }
+                else if (node == xml_reader::node_end_element)
+                {
+                    if (_state == state_document)
+                    {
+                        _failed = true;
+                        _state = state_done;
+                        break;
+                    }
+                    _state = _state == state_worksheet ? state_done : state_worksheet;
+                }
+                else if (node == xml_reader::node_element)
+                {
+                    auto name = xml.name();
+                    if (_state == state_document)
+                        _state = name == "worksheet" && !xml.empty_element() ? state_worksheet : state_done;
+                    else if (_state == state_worksheet && name == "sheetData" && !_sheet_data)
+                    {
+                        _sheet_data = true;
+                        if (!xml.empty_element())
+                            _state = state_sheet_data;
+                    }
+                    else if (_state == state_worksheet && name == "mergeCells" && !_merge_cells_read)
+                    {
+                        _merge_cells_read = true;
+                        if (!xml.empty_element())
+                            _state = state_merge_cells;
+                    }
+                    else if (_state == state_sheet_data && name == "row")
+                    {
+                        if (_row_count >= _range.limit)
+                        {
+                            _stopped = true;
+                            _state = state_done;
+                            break;
+                        }
+                        auto row_index = _row_index;
+                        if (!read_row(xml))
+                        {
+                            if (final || xml.malformed())
+                            {
+                                _failed = true;
+                                _state = state_done;
+                            }
+                            else
+                                _row_index = row_index; // retried with more data
+                            break;
+                        }
+                        bool empty = raw ? _raw_cells.empty() : _cells.empty();
+                        bool next = _row_index <= _range.last;
+                        if (next && !empty)
+                        {
+                            ++_rows_read;
+                            if constexpr (raw)
+                                next = on_row(_row_index, _raw_cells);
+                            else
+                                next = on_row(_row_index, _cells);
+                            next = next && ++_row_count < _range.limit;
+                        }
+                        if (!next)
+                        {
+                            _stopped = true;
+                            _state = state_done;
+                        }
+                    }
+                    else
+                    {
+                        if (_state == state_merge_cells && name == "mergeCell")
+                        {
+                            merge_cell range;
+                            if (read_range(xml.attribute("ref"), range.first, range.last, false))
+                                _merge_cells.push_back(range);
+                        }
+                        else if (_state == state_worksheet && name == "dimension" && !_sheet_data)
+                            read_range(xml.attribute("ref"), _dimension.first, _dimension.last, true);
+                        if (!xml.empty_element())
+                            _skip_depth = 1;
+                    }
+                }
+                consumed = xml.position();
+            }
+            if (final && _state != state_done)
+            {
+                _failed = true; // no document element or unclosed elements
+                _state = state_done;
             }
+            if (_statistics)
+                _parse_ns += statistics::now() - start;
+            return consumed - data;
         }
 
-        const std::vector<worksheet> &worksheets() const noexcept { return _worksheets; }
-        std::vector<worksheet>::const_iterator begin() const noexcept { return _worksheets.begin(); }
-        std::vector<worksheet>::const_iterator end() const noexcept { return _worksheets.end(); }
+        /**
+         * Parse a complete part held in one buffer, false if the markup is broken.
+         */
+        template <typename Callback>
+        bool read(const char *data, size_t size, Callback &&on_row)
+        {
+            feed(data, size, true, on_row);
+            return !_failed;
+        }
     };
 
     class worksheet
@@ -205,26 +2517,25 @@ namespace xlsxtext
         workbook *_workbook;
 
         std::string _part;
+        int _file = -1; // file index of the part in the zip readers of the workbook
         std::string _name;
-        std::vector<std::tuple<reference, reference, std::string>> _merge_cells;
-        std::vector<std::vector<cell>> _rows;
+        merge_index _merges;
+        sheet_dimension _dimension;
+        packed_rows _rows;
 
     public:
         worksheet(workbook *wb) noexcept : _workbook(wb) {}
-        worksheet(const std::string &name, const std::string &part, workbook *wb) noexcept : _name(name), _part(part), _workbook(wb) {}
+        worksheet(const std::string &name, const std::string &part, workbook *wb) noexcept : _name(name), _part(part), _workbook(wb) { _file = wb->_locate(part); }
 
-    public:
-        std::string name() const noexcept { return _name; }
-        std::map<std::string, std::string> read()
+    private:
+        template <typename Callback>
+        bool scan(mz_zip_archive &archive, read_errors &errors, Callback &&on_row, const columns &cols = {}, const row_range &range = {})
         {
-            _merge_cells.clear();
-            _rows.clear();
+            _merges = merge_index();
+            _dimension = {};
 
-            std::map<std::string, std::string> errors;
-
-            void *buffer = nullptr;
-            size_t size = 0;
-            if ((buffer = _workbook->extract_file(_part, &size)) != nullptr)
+            part_reader part(_file < 0 ? nullptr : mz_zip_reader_extract_iter_new(&archive, _file, 0), _workbook->_statistics, _part);
+            if (part)
             {
                 /**
                  * <xsd:simpleType name="ST_Xstring">
@@ -320,92 +2631,491 @@ namespace xlsxtext
                  *     </mergeCells>
                  * <worksheet>
                  */
-                pugi::xml_document doc;
-                auto result = doc.load_buffer_inplace_own(buffer, size);
-                if (!result)
+                std::vector<merge_range> merge_cells;
+                sheet_reader reader(*_workbook, errors, merge_cells, _dimension, cols, range);
+                std::string pending; // unconsumed tail of the previous chunk followed by the next chunk
+                size_t consumed = 0;
+                for (;;)
+                {
+                    pending.erase(0, consumed);
+                    // a row still unfinished is parsed again from its start: read at least as much as is pending so that the
+                    // buffer doubles and the cost of parsing a very wide row stays linear
+                    auto size = pending.size();
+                    auto wanted = std::max(part_reader::chunk_size, size);
+                    pending.resize(size + wanted);
+                    size_t read = 0;
+                    for (size_t n; read < wanted && (n = part.read(&pending[size + read], wanted - read)) > 0;)
+                        read += n;
+                    pending.resize(size + read);
+
+                    consumed = reader.feed(pending.data(), pending.size(), read == 0, on_row);
+                    if (read == 0 || reader.stopped() || reader.failed())
+                        break;
+                }
+                if (reader.failed() || (!reader.stopped() && !part.close()))
                 {
-                    errors[_name] = "workseet open failed";
-                    return errors;
+                    part.close(); // a broken part is not inflated any further
+                    errors.clear();
+                    errors.add(0, 0, read_error::open_failed);
+                    return false;
                 }
+                _merges = merge_index(std::move(merge_cells));
+            }
+            else if (_file >= 0) // the part exists but cannot be read, e.g. a read callback failed
+            {
+                errors.add(0, 0, read_error::open_failed);
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Presize the rows for the dimension of the sheet and the rows in range, trusting the hint no further than the
+         * part size allows: every cell takes at least 8 bytes of markup.
+         */
+        void reserve_rows(mz_zip_archive &archive, const columns &cols, const row_range &range)
+        {
+            mz_zip_archive_file_stat stat;
+            if (!_dimension || _file < 0 || !mz_zip_reader_file_stat(&archive, _file, &stat))
+                return;
+            std::uint64_t most = stat.m_uncomp_size / 8;
+            std::uint64_t rows = _dimension.rows();
+            if (range.last >= range.first)
+                rows = std::min<std::uint64_t>(rows, static_cast<std::uint64_t>(range.last) - range.first + 1);
+            rows = std::min<std::uint64_t>({rows, range.limit, most});
+            auto cells = std::min<std::uint64_t>(cols.empty() ? rows * _dimension.cols() : rows, most);
+            _rows.reserve(static_cast<size_t>(rows), static_cast<size_t>(cells), 0);
+        }
+
+        read_errors read(mz_zip_archive &archive, const columns &cols = {}, const row_range &range = {})
+        {
+            _rows.clear();
+
+            read_errors errors(_workbook->_error_limit);
+            if (!scan(archive, errors, [&](unsigned index, std::vector<cell> &cells)
+                      { if (_rows.empty())
+                            reserve_rows(archive, cols, range);
+                        _rows.push_back(index, cells);
+                        return true; }, cols, range))
+                _rows.clear();
+            _rows.shrink_to_fit();
+            _rows.index_rows();
+            return errors;
+        }
+
+        template <typename Cell, typename Callback>
+        read_errors for_each(Callback &callback, const columns &cols, const row_range &range)
+        {
+            read_errors errors(_workbook->_error_limit);
+            scan(_workbook->_archive, errors, [&callback](unsigned index, std::vector<Cell> &cells)
+                 {
+                    basic_row_view<Cell> row(index, cells.data(), cells.size());
+                    if constexpr (std::is_same_v<std::invoke_result_t<Callback &, const basic_row_view<Cell> &>, bool>)
+                        return callback(row);
+                    else
+                    {
+                        callback(row);
+                        return true;
+                    } }, cols, range);
+            return errors;
+        }
+
+        friend class workbook;
+
+    public:
+        std::string name() const noexcept { return _name; }
 
-                for (auto mc = doc.child("worksheet").child("mergeCells").child("mergeCell"); mc; mc = mc.next_sibling("mergeCell"))
+        /**
+         * Offsets splitting the sheetData of an inflated part into at most count pieces, each (but the first) starting
+         * at a row element with an r attribute so that it can be parsed without the rows before it.
+         */
+        static std::vector<size_t> split_rows(const char *data, size_t size, size_t count)
+        {
+            std::vector<size_t> splits{0};
+            std::string_view part(data, size);
+            auto begin = part.find("<sheetData"), end = part.rfind("</sheetData>");
+            if (begin != std::string_view::npos && end != std::string_view::npos && begin < end)
+            {
+                for (size_t i = 1; i < count; ++i)
                 {
-                    auto ref = mc.attribute("ref");
-                    if (ref)
+                    auto p = std::max(splits.back() + 1, begin + (end - begin) / count * i);
+                    while ((p = part.find("<row", p)) < end)
                     {
-                        std::string refs = ref.value();
-                        auto split = refs.find(':');
-                        if (split != std::string::npos && split < refs.size() - 1)
-                            _merge_cells.push_back({refs.substr(0, split), refs.substr(split + 1), ""});
+                        xml_reader xml(data + p, data + end);
+                        if (xml.next() == xml_reader::node_element && xml.name() == "row" && !xml.attribute("r").empty())
+                            break;
+                        ++p;
                     }
+                    if (p >= end)
+                        break;
+                    splits.push_back(p);
                 }
-                unsigned row_index = 0, col_index = 0;
-                for (auto row = doc.child("worksheet").child("sheetData").child("row"); row; row = row.next_sibling("row"))
-                {
-                    std::string r = row.attribute("r").value();
-                    row_index = r == "" ? row_index + 1 : std::stol(r);
-                    col_index = 0;
+            }
+            splits.push_back(size);
+            return splits;
+        }
 
-                    std::vector<cell> cells;
-                    for (auto c = row.child("c"); c; c = c.next_sibling("c"))
-                    {
-                        reference refer(c.attribute("r").value()); // "r" is optional
-                        if (!refer)
-                        {
-                            refer.row = row_index;
-                            refer.col = ++col_index;
-                        }
-                        col_index = refer.col;
+        read_errors read() { return read(_workbook->_archive); }
+        /**
+         * Read only the projected columns, rows without any of them are left out.
+         */
+        read_errors read(const columns &cols) { return read(_workbook->_archive, cols); }
+        /**
+         * Read only the rows in range (and the projected columns), stopping as soon as the range is exhausted.
+         */
+        read_errors read(const row_range &range, const columns &cols = {}) { return read(_workbook->_archive, cols, range); }
 
-                        if (refer.row != row_index) // Error in Microsoft Excel
-                            continue;
+        /**
+         * Read the sheet with up to threads workers (0: one per hardware thread) for single huge sheets.
+         * The part is inflated to memory and split at row elements; every piece is parsed and formatted on its own
+         * thread and the rows, merge cells and errors are stitched back in document order, identical to read().
+         */
+        read_errors read(unsigned threads, const columns &cols = {})
+        {
+            static constexpr size_t min_piece_size = 1 << 20;
 
-                        std::string v = c.child("v").text().get(), t = c.attribute("t").value(), s = c.attribute("s").value();
-                        /**
-                         * (Ecma Office Open XML Part 1)
-                         *
-                         * when the cell's type t is inlineStr then only the element is is allowed as a child element.
-                         *
-                         * Cell containing an (inline) rich string, i.e., one not in the shared string table. If this cell type is used, then the cell value is in the is element rather than the v element in the cell (c element).
-                         */
-                        if (t == "inlineStr")
-                        {
-                            v = "";
-                            auto is = c.child("is");
-                            auto r = is.child("r");
-                            if (r)
-                            {
-                                for (; r; r = r.next_sibling("r"))
-                                    v += r.child("t").text().get();
-                            }
-                            else
-                                v = is.child("t").text().get();
-                        }
+            if (threads == 0)
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            if (threads == 1)
+                return read(cols);
 
-                        std::string error, value = c.child("f") ? v : _workbook->read_value(v, t, s, error);
-                        if (error != "")
-                            errors[refer.value()] = error;
-                        cells.push_back(cell(refer, value));
-                    }
+            _merges = merge_index();
+            _dimension = {};
+            _rows.clear();
 
-                    if (cells.size())
-                        _rows.push_back(std::move(cells));
+            read_errors errors(_workbook->_error_limit);
+            size_t size = 0;
+            statistics::timer inflate(_workbook->_statistics, statistics::phase_inflate);
+            std::unique_ptr<char, void (*)(void *)> buffer(static_cast<char *>(_file < 0 ? nullptr : mz_zip_reader_extract_to_heap(&_workbook->_archive, _file, &size, 0)), mz_free);
+            inflate.stop();
+            if (_file >= 0 && _workbook->_statistics)
+                _workbook->_count_part(_workbook->_archive, _file, _part, buffer != nullptr);
+            if (!buffer)
+            {
+                if (_file >= 0)
+                    errors.add(0, 0, read_error::open_failed);
+                return errors;
+            }
+
+            struct piece
+            {
+                read_errors errors;
+                std::vector<sheet_reader::merge_cell> merge_cells;
+                sheet_dimension dimension;
+                packed_rows rows;
+                bool ok = false;
+                std::exception_ptr exception;
+            };
+            auto splits = split_rows(buffer.get(), size, std::min<size_t>(threads, size / min_piece_size + 1));
+            std::vector<piece> pieces(splits.size() - 1);
+            for (auto &piece : pieces)
+                piece.errors = read_errors(_workbook->_error_limit);
+            auto parse = [&](size_t i)
+            {
+                auto &piece = pieces[i];
+                try
+                {
+                    sheet_reader reader(*_workbook, piece.errors, piece.merge_cells, piece.dimension, cols);
+                    if (i > 0)
+                        reader.start_in_sheet_data();
+                    bool final = i + 1 == pieces.size();
+                    auto length = splits[i + 1] - splits[i];
+                    auto consumed = reader.feed(buffer.get() + splits[i], length, final, [&piece](unsigned index, std::vector<cell> &cells)
+                                                { piece.rows.push_back(index, cells);
+                                                  return true; });
+                    piece.ok = !reader.failed() && (final || (consumed == length && !reader.done()));
+                }
+                catch (...)
+                {
+                    piece.exception = std::current_exception();
                 }
+            };
+
+            std::vector<std::thread> workers;
+            for (size_t i = 1; i < pieces.size(); ++i)
+                workers.emplace_back(parse, i);
+            parse(0);
+            for (auto &worker : workers)
+                worker.join();
+
+            for (auto &piece : pieces)
+            {
+                if (piece.exception)
+                    std::rethrow_exception(piece.exception);
+                if (!piece.ok)
+                    return read(cols); // a split point inside a comment or a broken part, let the serial reader decide
+            }
+            size_t rows = 0, cells = 0, text = 0;
+            for (auto &piece : pieces)
+            {
+                rows += piece.rows._rows.size();
+                cells += piece.rows._cols.size();
+                text += piece.rows._text.size();
+            }
+            _rows.reserve(rows, cells, text);
+            std::vector<merge_range> merge_cells;
+            for (auto &piece : pieces)
+            {
+                errors.append(piece.errors);
+                merge_cells.insert(merge_cells.end(), piece.merge_cells.begin(), piece.merge_cells.end());
+                _rows.append(piece.rows);
+                piece.rows.clear();
+                piece.rows.shrink_to_fit();
             }
+            _merges = merge_index(std::move(merge_cells));
+            _dimension = pieces[0].dimension;
+            _rows.index_rows();
             return errors;
         }
 
-        const std::vector<std::vector<cell>> &rows() const noexcept { return _rows; }
-        std::vector<std::vector<cell>>::const_iterator begin() const noexcept { return _rows.begin(); }
-        std::vector<std::vector<cell>>::const_iterator end() const noexcept { return _rows.end(); }
+        /**
+         * Stream the rows into callback(const row_view &) without materialising rows().
+         * The view is backed by one reused row buffer and is only valid during the call.
+         * A callback returning bool can return false to stop reading early.
+         * With cols only the projected cells are parsed and formatted, with range only the rows in it.
+         */
+        template <typename Callback>
+        read_errors for_each_row(Callback &&callback, const columns &cols = {}, const row_range &range = {}) { return for_each<cell>(callback, cols, range); }
+        template <typename Callback>
+        read_errors for_each_row(Callback &&callback, const row_range &range, const columns &cols = {}) { return for_each<cell>(callback, cols, range); }
+
+        /**
+         * Stream the rows as typed values into callback(const raw_row_view &), as for_each_row.
+         * No value is formatted unless raw_cell::text() is called, so numeric pipelines skip number formats entirely.
+         */
+        template <typename Callback>
+        read_errors for_each_raw_row(Callback &&callback, const columns &cols = {}, const row_range &range = {}) { return for_each<raw_cell>(callback, cols, range); }
+        template <typename Callback>
+        read_errors for_each_raw_row(Callback &&callback, const row_range &range, const columns &cols = {}) { return for_each<raw_cell>(callback, cols, range); }
+
+        /**
+         * The rows stored by read(), packed; iterating yields views with index(), size() and cells with refer and value.
+         */
+        const packed_rows &rows() const noexcept { return _rows; }
+        packed_rows::const_iterator begin() const noexcept { return _rows.begin(); }
+        packed_rows::const_iterator end() const noexcept { return _rows.end(); }
+
+        /**
+         * The merged ranges of the last read or scan, e.g. merges().find("B17") for the range covering B17.
+         * mergeCells follows sheetData in the part, so reads stopped early by a row range have none.
+         */
+        const merge_index &merges() const noexcept { return _merges; }
+
+        /**
+         * The dimension element of the part as of the last read or scan, false when the sheet has none. It is a hint
+         * for sizing buffers, rows() is what was actually read.
+         */
+        const sheet_dimension &dimension() const noexcept { return _dimension; }
+
+        /**
+         * The cell stored by read() at a reference, its refer is false (and its value empty) when there is none.
+         * A row number table lookup then a binary search in the row, O(log cols).
+         */
+        packed_cell at(unsigned row, unsigned col) const noexcept
+        {
+            packed_cell cell{};
+            auto i = _rows.find_row(row);
+            if (i == packed_rows::npos || !_rows.find_cell(i, col, cell))
+                return {};
+            return cell;
+        }
+        packed_cell at(const reference &refer) const noexcept { return at(refer.row, refer.col); }
+
+        /**
+         * Give every cell covered by a merged range the value of its top-left anchor, creating the rows and cells
+         * missing from rows() within the used range (up to the last row and the last column holding a cell).
+         * One sweep over the rows with the ranges crossing the current row, O(cells + filled cells + ranges log ranges).
+         */
+        void fill_merged_cells()
+        {
+            if (_merges.empty() || _rows._cols.empty())
+                return;
+            std::vector<size_t> rows; // rows by index when they are stored out of order
+            if (!_rows._ordered && !std::is_sorted(_rows._rows.begin(), _rows._rows.end(), [](const auto &a, const auto &b)
+                                                   { return a.index < b.index; }))
+            {
+                for (size_t i = 0; i < _rows.size(); ++i)
+                    rows.push_back(i);
+                std::stable_sort(rows.begin(), rows.end(), [this](size_t a, size_t b)
+                                 { return _rows._rows[a].index < _rows._rows[b].index; });
+            }
+            auto max_row = _rows._rows[rows.empty() ? _rows.size() - 1 : rows.back()].index;
+            auto max_col = *std::max_element(_rows._cols.begin(), _rows._cols.end());
+
+            struct fill
+            {
+                merge_range range;
+                std::string_view value; // of the anchor, in _rows until it is replaced
+            };
+            std::vector<fill> fills;
+            for (auto &range : _merges.ranges())
+            {
+                packed_cell anchor;
+                auto row = _rows.find_row(range.first.row);
+                if (range.first.col <= max_col && row != packed_rows::npos && _rows.find_cell(row, range.first.col, anchor) && !anchor.value.empty())
+                    fills.push_back({range, anchor.value});
+            }
+            std::sort(fills.begin(), fills.end(), [](const fill &a, const fill &b)
+                      { return a.range.first.row < b.range.first.row; });
+
+            packed_rows filled;
+            filled.reserve(_rows.size(), _rows.cell_count(), _rows._text.size());
+            std::vector<const fill *> active; // ranges crossing the current row, by first column
+            std::vector<size_t> order;        // cells of the current row by column when it is stored out of order
+            size_t next_row = 0, next_fill = 0;
+            for (unsigned row = 0;;)
+            {
+                auto index = std::numeric_limits<unsigned>::max();
+                auto current = rows.empty() || next_row >= rows.size() ? next_row : rows[next_row];
+                if (next_row < _rows.size())
+                    index = _rows._rows[current].index;
+                if (next_fill < fills.size())
+                    index = std::min(index, fills[next_fill].range.first.row);
+                if (!active.empty())
+                    index = std::min(index, row + 1);
+                if (index > max_row)
+                    break;
+                row = index;
+
+                active.erase(std::remove_if(active.begin(), active.end(), [row](const fill *f)
+                                            { return f->range.last.row < row; }),
+                             active.end());
+                if (next_fill < fills.size() && fills[next_fill].range.first.row <= row)
+                {
+                    while (next_fill < fills.size() && fills[next_fill].range.first.row <= row)
+                        active.push_back(&fills[next_fill++]);
+                    std::sort(active.begin(), active.end(), [](const fill *a, const fill *b)
+                              { return a->range.first.col < b->range.first.col; });
+                }
+
+                auto has_row = next_row < _rows.size() && _rows._rows[current].index == row;
+                size_t first = has_row ? _rows._rows[current].first : 0, end = has_row ? _rows.row_end(current) : 0, cell = first;
+                order.clear();
+                if (!_rows._ordered && !std::is_sorted(_rows._cols.begin() + first, _rows._cols.begin() + end))
+                {
+                    for (auto i = first; i < end; ++i)
+                        order.push_back(i);
+                    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b)
+                                     { return _rows._cols[a] < _rows._cols[b]; });
+                }
+                auto col_of = [&](size_t cell)
+                { return _rows._cols[order.empty() ? cell : order[cell - first]]; };
+                bool pushed = false; // the row is only added with its first cell, a range can end above it
+                auto push = [&](unsigned col, std::string_view value)
+                {
+                    if (!pushed)
+                        filled.push_row(row);
+                    pushed = true;
+                    filled.push_cell(col, value);
+                };
+                auto copy = [&]
+                {
+                    auto i = order.empty() ? cell : order[cell - first];
+                    push(_rows._cols[i], _rows.cell_at(current, i).value);
+                    ++cell;
+                };
+                unsigned col = 0; // last column written
+                for (auto f : active)
+                {
+                    while (cell < end && col_of(cell) < f->range.first.col)
+                    {
+                        col = col_of(cell);
+                        copy();
+                    }
+                    for (auto last = std::min(f->range.last.col, max_col); col < last;)
+                    {
+                        col = std::max(col + 1, f->range.first.col);
+                        if (row == f->range.first.row && col == f->range.first.col && cell < end && col_of(cell) == col)
+                            copy();
+                        else
+                            push(col, f->value);
+                        while (cell < end && col_of(cell) == col)
+                            ++cell;
+                    }
+                }
+                while (cell < end)
+                    copy();
+                next_row += has_row;
+            }
+            filled.shrink_to_fit();
+            filled.index_rows();
+            _rows = std::move(filled);
+        }
     };
 
-    inline bool workbook::read() noexcept
+    inline std::vector<read_errors> workbook::read_all(unsigned threads)
+    {
+        std::vector<read_errors> errors(_worksheets.size(), read_errors(_error_limit));
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min<unsigned>(threads, static_cast<unsigned>(_worksheets.size()));
+        if (threads <= 1)
+        {
+            for (size_t i = 0; i < _worksheets.size(); ++i)
+                errors[i] = _worksheets[i].read(_archive);
+            return errors;
+        }
+
+        std::vector<std::exception_ptr> exceptions(_worksheets.size());
+        std::atomic<size_t> next{0};
+        auto work = [&]
+        {
+            mz_zip_archive archive;
+            bool opened = _open_archive(archive);
+            for (size_t i; (i = next++) < _worksheets.size();)
+            {
+                if (!opened)
+                {
+                    errors[i].add(0, 0, read_error::open_failed);
+                    continue;
+                }
+                try
+                {
+                    errors[i] = _worksheets[i].read(archive);
+                }
+                catch (...)
+                {
+                    exceptions[i] = std::current_exception();
+                }
+            }
+            if (opened)
+                mz_zip_reader_end(&archive);
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned i = 0; i < threads; ++i)
+            workers.emplace_back(work);
+        for (auto &worker : workers)
+            worker.join();
+
+        for (auto &exception : exceptions)
+            if (exception)
+                std::rethrow_exception(exception);
+        return errors;
+    }
+
+    inline bool workbook::read(bool lazy_shared_strings) noexcept
     {
         _worksheets.clear();
+        _cell_xfs.clear();
+        _xf_formats.clear();
+        _shared_strings.clear();
+        _shared_string_offsets.assign(1, 0);
+        _lazy_shared_strings = false;
+        _shared_strings_xml.reset();
+        _si_offsets.clear();
+        _decoded.reset();
+        _decoded_strings.clear();
 
-        if (!mz_zip_reader_init_file(&_archive, _path.c_str(), 0))
+        mz_zip_reader_end(&_archive);
+        _mapping.close();
+        statistics::timer open(_statistics, statistics::phase_open);
+        if (_memory_map && !_mapping.open(_path))
             return false;
+        if (!_open_archive(_archive))
+            return false;
+        _index_files();
+        open.stop();
 
         std::string workbook_part = "xl/workbook.xml";
         std::string shared_strings_part = "xl/sharedStrings.xml";
@@ -441,6 +3151,7 @@ namespace xlsxtext
              *     <Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument" Target="xl/workbook.xml"/>
              * </Relationships>
              */
+            statistics::timer timer(_statistics, statistics::phase_relationships);
             auto result = doc.load_buffer_inplace_own(buffer, size);
             if (!result)
                 return false;
@@ -482,6 +3193,7 @@ namespace xlsxtext
              *     <Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet" Target="worksheets/sheet1.xml"/>
              * </Relationships>
              */
+            statistics::timer timer(_statistics, statistics::phase_relationships);
             auto result = doc.load_buffer_inplace_own(buffer, size);
             if (!result)
                 return false;
@@ -501,7 +3213,17 @@ namespace xlsxtext
                 }
             }
         }
-        if (shared_strings_part != "" && (buffer = extract_file(shared_strings_part, &size)) != nullptr)
+        if (shared_strings_part != "" && lazy_shared_strings && (buffer = extract_file(shared_strings_part, &size)) != nullptr)
+        {
+            statistics::timer timer(_statistics, statistics::phase_shared_strings);
+            _lazy_shared_strings = true;
+            _shared_strings_xml.reset(static_cast<char *>(buffer));
+            _shared_strings_xml_size = size;
+            if (!_scan_shared_strings())
+                return false;
+            _decoded.reset(new std::atomic<const std::string *>[_si_offsets.size()]());
+        }
+        else if (shared_strings_part != "" && (buffer = extract_file(shared_strings_part, &size)) != nullptr)
         {
             /**
              * <xsd:simpleType name="ST_Xstring">
@@ -537,23 +3259,28 @@ namespace xlsxtext
              *     <si><t>cd</t></si>
              * </sst>
              */
+            statistics::timer timer(_statistics, statistics::phase_shared_strings);
             auto result = doc.load_buffer_inplace_own(buffer, size);
             if (!result)
                 return false;
 
-            for (auto si = doc.child("sst").child("si"); si; si = si.next_sibling("si"))
+            auto sst = doc.child("sst");
+            // the hint is trusted no further than the part size allows: every si element takes at least 5 bytes
+            _shared_string_offsets.reserve(static_cast<size_t>(std::min<std::uint64_t>(sst.attribute("uniqueCount").as_uint(), size / 5)) + 1);
+            for (auto si = sst.child("si"); si; si = si.next_sibling("si"))
             {
-                std::string t;
                 auto r = si.child("r");
                 if (r)
                 {
                     for (; r; r = r.next_sibling("r"))
-                        t += r.child("t").text().get();
+                        _shared_strings += r.child("t").text().get();
                 }
                 else
-                    t = si.child("t").text().get();
-                _shared_strings.push_back(t);
+                    _shared_strings += si.child("t").text().get();
+                _shared_string_offsets.push_back(_shared_strings.size());
             }
+            _shared_strings.shrink_to_fit();
+            _shared_string_offsets.shrink_to_fit();
         }
         if (styles_part != "" && (buffer = extract_file(styles_part, &size)) != nullptr)
         {
@@ -604,6 +3331,7 @@ namespace xlsxtext
              *     </cellXfs>
              * </styleSheet>
              */
+            statistics::timer timer(_statistics, statistics::phase_styles);
             auto result = doc.load_buffer_inplace_own(buffer, size);
             if (!result)
                 return false;
@@ -625,6 +3353,9 @@ namespace xlsxtext
                 }
             }
         }
+        statistics::timer compile(_statistics, statistics::phase_styles);
+        _compile_formats();
+        compile.stop();
         if ((buffer = extract_file(workbook_part, &size)) != nullptr)
         {
             /**
@@ -660,6 +3391,7 @@ namespace xlsxtext
              *     <workbookPr date1904="1"/>
              * </workbook>
              */
+            statistics::timer timer(_statistics, statistics::phase_workbook);
             auto result = doc.load_buffer_inplace_own(buffer, size);
             if (!result)
                 return false;